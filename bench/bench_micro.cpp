@@ -0,0 +1,324 @@
+// Microbenchmarks for the move generator's hot paths.
+//
+// Every operation is timed separately on each category of a fixed position
+// corpus and reported in ns/op, so a regression can be traced to the
+// component that caused it. Each measurement is calibrated to run for at
+// least --min-ms, warmed up once, then repeated --reps times.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "chess/alloc_stats.h"
+#include "chess/attack.h"
+#include "chess/fen.h"
+#include "chess/magic.h"
+#include "chess/makemove.h"
+#include "chess/movegen.h"
+#include "chess/movelist.h"
+#include "chess/perf_counters.h"
+#include "chess/position.h"
+#include "chess/undo.h"
+#include "chess/zobrist.h"
+
+// ------------------------------------------------------------
+// Corpus
+// ------------------------------------------------------------
+//
+// Endgame and promotion positions are lines of data/perftsuite.epd. The
+// suite has a single opening and a single middlegame position (lines 1
+// and 2), so those categories add well-known opening lines and the other
+// standard perft positions.
+
+struct Category {
+    const char* name;
+    std::vector<const char*> fens;
+};
+
+static const std::vector<Category> CORPUS = {
+    { "opening", {
+        "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",          // epd 1
+        "rnbqkbnr/pp1ppppp/8/2p5/4P3/8/PPPP1PPP/RNBQKBNR w KQkq c6 0 2",
+        "r1bqkbnr/pppp1ppp/2n5/1B2p3/4P3/5N2/PPPP1PPP/RNBQK2R b KQkq - 3 3",
+        "rnbqkb1r/pppp1ppp/4pn2/8/2PP4/8/PP2PPPP/RNBQKBNR w KQkq - 0 3",
+    } },
+    { "middlegame", {
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", // epd 2
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+        "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+        "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    } },
+    { "endgame", {
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",    // epd 127
+        "r3k2r/8/8/8/8/8/8/R3K2R b KQkq - 0 1",         // epd 30
+        "8/1n4N1/2k5/8/8/5K2/1N4n1/8 w - - 0 1",        // epd 37
+        "R6r/8/8/2K5/5k2/8/8/r6R w - - 0 1",            // epd 56
+        "K7/8/8/3Q4/4q3/8/8/7k w - - 0 1",              // epd 61
+        "3k4/3pp3/8/8/8/8/3PP3/3K4 w - - 0 1",          // epd 111
+    } },
+    { "promotion", {
+        "8/Pk6/8/8/8/8/6Kp/8 w - - 0 1",                // epd 119
+        "n1n5/1Pk5/8/8/8/8/5Kp1/5N1N w - - 0 1",        // epd 120
+        "8/PPPk4/8/8/8/8/4Kppp/8 w - - 0 1",            // epd 121
+        "n1n5/PPPk4/8/8/8/8/4Kppp/5N1N b - - 0 1",      // epd 126
+    } },
+};
+
+struct Sample {
+    std::string fen;
+    chess::Position pos;
+    chess::MoveList legal;
+};
+
+// Results are folded in here so the compiler cannot drop the work.
+static volatile std::uint64_t g_sink = 0;
+
+// ------------------------------------------------------------
+// Operations: one pass over the samples, returning the number of ops done
+// ------------------------------------------------------------
+
+static std::uint64_t op_pseudo_legal(std::vector<Sample>& samples) {
+    std::uint64_t sink = 0;
+    for (const Sample& s : samples) {
+        chess::MoveList moves;
+        chess::generate_pseudo_legal(s.pos, moves);
+        sink += moves.size();
+    }
+    g_sink = g_sink + sink;
+    return samples.size();
+}
+
+static std::uint64_t op_legal(std::vector<Sample>& samples) {
+    std::uint64_t sink = 0;
+    for (const Sample& s : samples) {
+        chess::MoveList moves;
+        chess::generate_legal(s.pos, moves);
+        sink += moves.size();
+    }
+    g_sink = g_sink + sink;
+    return samples.size();
+}
+
+static std::uint64_t op_count_legal(std::vector<Sample>& samples) {
+    std::uint64_t sink = 0;
+    for (const Sample& s : samples) sink += chess::count_legal(s.pos);
+    g_sink = g_sink + sink;
+    return samples.size();
+}
+
+static std::uint64_t op_make_undo(std::vector<Sample>& samples) {
+    std::uint64_t sink = 0, ops = 0;
+    for (Sample& s : samples) {
+        for (const chess::Move m : s.legal) {
+            chess::Undo u;
+            chess::make_move(s.pos, m, u);
+            sink += s.pos.key();
+            chess::undo_move(s.pos, m, u);
+        }
+        ops += s.legal.size();
+    }
+    g_sink = g_sink + sink;
+    return ops;
+}
+
+static std::uint64_t op_square_attacked(std::vector<Sample>& samples) {
+    std::uint64_t sink = 0;
+    for (const Sample& s : samples) {
+        const chess::Color them = chess::opposite(s.pos.side_to_move());
+        for (int sq = 0; sq < 64; ++sq) sink += chess::is_square_attacked(s.pos, sq, them);
+    }
+    g_sink = g_sink + sink;
+    return samples.size() * 64;
+}
+
+static std::uint64_t op_zobrist(std::vector<Sample>& samples) {
+    std::uint64_t sink = 0;
+    for (const Sample& s : samples) sink ^= chess::zobrist_key(s.pos);
+    g_sink = g_sink + sink;
+    return samples.size();
+}
+
+static std::uint64_t op_from_fen(std::vector<Sample>& samples) {
+    std::uint64_t sink = 0;
+    chess::Position pos;
+    for (const Sample& s : samples) {
+        sink += chess::from_fen(s.fen, pos);
+        sink ^= pos.key();
+    }
+    g_sink = g_sink + sink;
+    return samples.size();
+}
+
+static std::uint64_t op_to_fen(std::vector<Sample>& samples) {
+    std::uint64_t sink = 0;
+    for (const Sample& s : samples) sink += chess::to_fen(s.pos).size();
+    g_sink = g_sink + sink;
+    return samples.size();
+}
+
+struct Operation {
+    const char* name;
+    std::uint64_t (*run)(std::vector<Sample>&);
+};
+
+static const Operation OPERATIONS[] = {
+    { "generate_pseudo_legal", op_pseudo_legal },
+    { "generate_legal", op_legal },
+    { "count_legal", op_count_legal },
+    { "make_move+undo_move", op_make_undo },
+    { "is_square_attacked", op_square_attacked },
+    { "zobrist_key", op_zobrist },
+    { "from_fen", op_from_fen },
+    { "to_fen", op_to_fen },
+};
+
+// ------------------------------------------------------------
+// Measurement
+// ------------------------------------------------------------
+
+struct Stats {
+    double mean = 0.0;
+    double min = 0.0;
+    double stddev = 0.0;
+    chess::PerfReading counters; // summed over the timed repetitions
+    chess::AllocCounts allocs;   // likewise
+    std::uint64_t ops = 0;       // ops done in the timed repetitions
+};
+
+// Time of `passes` passes, in ns per op.
+static double time_passes(const Operation& op, std::vector<Sample>& samples, std::uint64_t passes,
+                          std::uint64_t* ops_out = nullptr) {
+    std::uint64_t ops = 0;
+    const auto t0 = std::chrono::steady_clock::now();
+    for (std::uint64_t i = 0; i < passes; ++i) ops += op.run(samples);
+    const auto t1 = std::chrono::steady_clock::now();
+    const double ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+    if (ops_out) *ops_out += ops;
+    return ops ? ns / static_cast<double>(ops) : 0.0;
+}
+
+static Stats measure(const Operation& op, std::vector<Sample>& samples, int reps, double min_ms,
+                     chess::PerfCounters* perf) {
+    // Calibrate (this doubles as warmup): double the passes until one
+    // repetition takes at least min_ms.
+    std::uint64_t passes = 1;
+    while (true) {
+        const auto t0 = std::chrono::steady_clock::now();
+        for (std::uint64_t i = 0; i < passes; ++i) op.run(samples);
+        const auto t1 = std::chrono::steady_clock::now();
+        if (std::chrono::duration<double, std::milli>(t1 - t0).count() >= min_ms) break;
+        passes *= 2;
+    }
+    time_passes(op, samples, passes);
+
+    Stats s;
+    std::vector<double> runs;
+    runs.reserve(static_cast<std::size_t>(reps));
+    const chess::AllocScope allocs;
+    if (perf) perf->start();
+    for (int r = 0; r < reps; ++r) runs.push_back(time_passes(op, samples, passes, &s.ops));
+    if (perf) s.counters = perf->stop();
+    s.allocs = allocs.counts();
+
+    for (double v : runs) s.mean += v;
+    s.mean /= static_cast<double>(runs.size());
+    s.min = *std::min_element(runs.begin(), runs.end());
+    for (double v : runs) s.stddev += (v - s.mean) * (v - s.mean);
+    s.stddev = runs.size() > 1 ? std::sqrt(s.stddev / static_cast<double>(runs.size() - 1)) : 0.0;
+    return s;
+}
+
+static void print_usage() {
+    std::cerr << "Usage: bench_micro [--reps N] [--min-ms MS] [--op NAME] [--category NAME] [--counters]\n"
+              << "  --reps N         timed repetitions per measurement (default 10)\n"
+              << "  --min-ms MS      minimum duration of one repetition (default 20)\n"
+              << "  --op NAME        only operations whose name contains NAME\n"
+              << "  --category NAME  only this corpus category\n"
+              << "  --counters       print hardware counters per op below each row (Linux)\n";
+}
+
+int main(int argc, char** argv) {
+    int reps = 10;
+    double min_ms = 20.0;
+    std::string op_filter;
+    std::string category_filter;
+    bool counters = false;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        try {
+            if (arg == "--reps" && i + 1 < argc) {
+                reps = std::stoi(argv[++i]);
+                if (reps < 1) throw std::out_of_range("reps");
+            } else if (arg == "--min-ms" && i + 1 < argc) {
+                min_ms = std::stod(argv[++i]);
+                if (min_ms <= 0.0) throw std::out_of_range("min-ms");
+            } else if (arg == "--op" && i + 1 < argc) {
+                op_filter = argv[++i];
+            } else if (arg == "--category" && i + 1 < argc) {
+                category_filter = argv[++i];
+            } else if (arg == "--counters") {
+                counters = true;
+            } else {
+                print_usage();
+                return 2;
+            }
+        } catch (...) {
+            print_usage();
+            return 2;
+        }
+    }
+
+    std::vector<std::pair<const Category*, std::vector<Sample>>> sets;
+    for (const Category& c : CORPUS) {
+        if (!category_filter.empty() && category_filter != c.name) continue;
+
+        std::vector<Sample> samples;
+        for (const char* fen : c.fens) {
+            Sample s;
+            s.fen = fen;
+            if (!chess::from_fen(s.fen, s.pos)) {
+                std::cerr << "Bad corpus FEN: " << fen << "\n";
+                return 2;
+            }
+            chess::generate_legal(s.pos, s.legal);
+            samples.push_back(std::move(s));
+        }
+        sets.emplace_back(&c, std::move(samples));
+    }
+
+    std::unique_ptr<chess::PerfCounters> perf;
+    if (counters) {
+        perf = std::make_unique<chess::PerfCounters>();
+        if (!perf->available()) {
+            std::cerr << "No hardware counters: " << perf->error() << "\n";
+            perf.reset();
+        }
+    }
+
+    std::cout << "bench_micro: " << reps << " reps of >= " << min_ms << " ms after warmup (sliders: "
+              << chess::slider_backend_name(chess::slider_backend()) << ")\n";
+    std::printf("%-22s %-11s %4s %10s %10s %10s %7s\n",
+                "operation", "category", "pos", "ns/op", "min", "stddev", "cv%");
+
+    for (const Operation& op : OPERATIONS) {
+        if (!op_filter.empty() && std::string(op.name).find(op_filter) == std::string::npos) continue;
+
+        for (auto& [category, samples] : sets) {
+            const Stats s = measure(op, samples, reps, min_ms, perf.get());
+            std::printf("%-22s %-11s %4zu %10.2f %10.2f %10.2f %6.1f%%\n",
+                        op.name, category->name, samples.size(), s.mean, s.min, s.stddev,
+                        s.mean > 0.0 ? 100.0 * s.stddev / s.mean : 0.0);
+            if (s.counters.any()) std::printf("    %s\n", s.counters.per_node(s.ops, "op").c_str());
+            if (chess::alloc_stats_enabled) std::printf("    %s\n", s.allocs.per_node(s.ops, "op").c_str());
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,106 @@
+// Perft throughput benchmark with a baseline regression check.
+//
+//   bench_perft --json build/bench_baseline.json          # record a baseline
+//   bench_perft --baseline build/bench_baseline.json      # compare against it
+//
+// Prints the JSON report to stdout (comparison to stderr). Exits 1 when a
+// node count is wrong, total nodes/sec fell more than --threshold
+// percent below the baseline, or (ALLOC_STATS builds) a position
+// allocates more than in the baseline.
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "chess/bench.h"
+
+static void print_usage() {
+    std::cerr << "Usage: bench_perft [--reps N] [--json FILE] [--baseline FILE] [--threshold PCT] [--counters]\n"
+              << "  --reps N         runs per position, fastest counts (default 3)\n"
+              << "  --json FILE      also write the report to FILE\n"
+              << "  --baseline FILE  compare with a report written earlier\n"
+              << "  --threshold PCT  allowed drop in total nodes/sec (default 5)\n"
+              << "  --counters       also record hardware counters (Linux perf_event_open)\n";
+}
+
+int main(int argc, char** argv) {
+    int reps = 3;
+    double threshold = 5.0;
+    bool counters = false;
+    std::string json_path;
+    std::string baseline_path;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        try {
+            if (arg == "--reps" && i + 1 < argc) {
+                reps = std::stoi(argv[++i]);
+                if (reps < 1) throw std::out_of_range("reps");
+            } else if (arg == "--json" && i + 1 < argc) {
+                json_path = argv[++i];
+            } else if (arg == "--baseline" && i + 1 < argc) {
+                baseline_path = argv[++i];
+            } else if (arg == "--threshold" && i + 1 < argc) {
+                threshold = std::stod(argv[++i]);
+                if (threshold < 0.0) throw std::out_of_range("threshold");
+            } else if (arg == "--counters") {
+                counters = true;
+            } else {
+                print_usage();
+                return 2;
+            }
+        } catch (...) {
+            print_usage();
+            return 2;
+        }
+    }
+
+    // Read the baseline first: a bad path should not cost a full run.
+    chess::BenchReport baseline;
+    if (!baseline_path.empty()) {
+        std::ifstream in(baseline_path);
+        std::stringstream text;
+        text << in.rdbuf();
+        std::string error;
+        if (!in || !chess::bench_from_json(text.str(), baseline, error)) {
+            std::cerr << "Could not read baseline " << baseline_path << (error.empty() ? "" : ": ") << error
+                      << "\n";
+            return 2;
+        }
+    }
+
+    chess::BenchReport report;
+    if (counters) {
+        chess::PerfCounters probe;
+        if (!probe.available()) std::cerr << "No hardware counters: " << probe.error() << "\n";
+    }
+    const bool nodes_ok = chess::run_bench(reps, report, counters);
+    const std::string json = chess::bench_to_json(report);
+    std::cout << json;
+
+    for (const chess::BenchEntry& e : report.entries) {
+        if (e.counters.any()) std::cerr << e.name << ": " << e.counters.per_node(e.nodes) << "\n";
+        if (e.has_allocs) std::cerr << e.name << ": " << e.allocs.per_node(e.nodes) << "\n";
+    }
+
+    if (!json_path.empty()) {
+        std::ofstream out(json_path);
+        out << json;
+        if (!out) {
+            std::cerr << "Could not write " << json_path << "\n";
+            return 2;
+        }
+    }
+
+    if (!nodes_ok) {
+        std::cerr << "Wrong node count: the move generator is broken\n";
+        return 1;
+    }
+
+    if (!baseline_path.empty() && chess::report_bench_regression(std::cerr, report, baseline, threshold)) {
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace chess {
+
+// Heap allocation accounting.
+//
+// Built with -DCHESS_ALLOC_STATS (`make ALLOC_STATS=1`), the engine
+// replaces the global operator new/delete with versions that count every
+// allocation process-wide; otherwise all counts stay zero and nothing is
+// replaced. The perft and benchmark runners report the counts per node.
+
+#ifdef CHESS_ALLOC_STATS
+inline constexpr bool alloc_stats_enabled = true;
+#else
+inline constexpr bool alloc_stats_enabled = false;
+#endif
+
+struct AllocCounts {
+    std::uint64_t allocations = 0;
+    std::uint64_t bytes = 0; // requested, not counting allocator overhead
+    std::uint64_t frees = 0;
+
+    // "allocs/node 0.500  bytes/node 24.0"; empty unless alloc_stats_enabled.
+    std::string per_node(std::uint64_t nodes, const char* unit = "node") const;
+};
+
+AllocCounts operator-(const AllocCounts& a, const AllocCounts& b);
+
+// Totals since the process started, over all threads.
+AllocCounts alloc_counts();
+
+// Allocations (by any thread) since construction.
+class AllocScope {
+public:
+    AllocScope() : start_(alloc_counts()) {}
+    AllocCounts counts() const { return alloc_counts() - start_; }
+
+private:
+    AllocCounts start_;
+};
+
+} // namespace chess
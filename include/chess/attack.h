@@ -1,10 +1,39 @@
 #pragma once
 
+#include <array>
+
+#include "chess/bitboard.h"
 #include "chess/position.h"
 #include "chess/types.h"
 
 namespace chess {
 
+// ------------------------------------------------------------
+// Precomputed attack and geometry tables (constexpr, built by the compiler)
+// ------------------------------------------------------------
+
+using SquareTable = std::array<Bitboard, 64>;
+
+extern const SquareTable knight_attack_table;
+extern const SquareTable king_attack_table;
+extern const std::array<SquareTable, 2> pawn_attack_table; // [color][square]: squares a pawn of that color attacks
+extern const std::array<SquareTable, 64> between_table;
+extern const std::array<SquareTable, 64> line_table;
+
+inline Bitboard knight_attacks(int sq) { return knight_attack_table[sq]; }
+inline Bitboard king_attacks(int sq) { return king_attack_table[sq]; }
+inline Bitboard pawn_attacks(Color c, int sq) { return pawn_attack_table[c][sq]; }
+
+// Squares strictly between a and b if they share a rank, file or diagonal; else empty.
+inline Bitboard between_bb(int a, int b) { return between_table[a][b]; }
+
+// The full rank/file/diagonal through a and b (including both); empty if not aligned.
+inline Bitboard line_bb(int a, int b) { return line_table[a][b]; }
+
+// All pieces of either color attacking `square`, with sliders blocked by `occupied`
+// (which may differ from the position's occupancy, e.g. with the king lifted off).
+Bitboard attackers_to(const Position& pos, int square, Bitboard occupied);
+
 // Returns true if `square` is attacked by side `by` in the given position.
 bool is_square_attacked(const Position& pos, int square, Color by);
 
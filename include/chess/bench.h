@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include "chess/alloc_stats.h"
+#include "chess/perf_counters.h"
+
+namespace chess {
+
+// Fixed perft workload used to track move generator throughput.
+struct BenchPosition {
+    const char* name;
+    const char* fen;
+    int depth;
+    std::uint64_t nodes; // known perft(depth), checked on every run
+};
+
+const std::vector<BenchPosition>& bench_positions();
+
+struct BenchEntry {
+    std::string name;
+    std::string fen;
+    int depth = 0;
+    std::uint64_t nodes = 0;
+    double ms = 0.0; // best of the repetitions
+    PerfReading counters; // of the best repetition, if requested and available
+    AllocCounts allocs;   // of one repetition, if has_allocs (ALLOC_STATS build)
+    bool has_allocs = false;
+
+    double nps() const { return ms > 0.0 ? static_cast<double>(nodes) * 1000.0 / ms : 0.0; }
+};
+
+struct BenchReport {
+    std::string sliders; // slider backend the numbers were taken with
+    int reps = 0;
+    std::vector<BenchEntry> entries;
+
+    std::uint64_t nodes() const;
+    double ms() const;
+    double nps() const { return ms() > 0.0 ? static_cast<double>(nodes()) * 1000.0 / ms() : 0.0; }
+};
+
+// Runs every bench position `reps` times with single-threaded perft (no
+// hash table) and keeps the fastest time of each, with its hardware
+// counters if `counters` is set. Returns false if a node count is wrong;
+// the report is filled in either way.
+bool run_bench(int reps, BenchReport& out, bool counters = false);
+
+std::string bench_to_json(const BenchReport& report);
+
+// Reads a report written by bench_to_json.
+bool bench_from_json(const std::string& json, BenchReport& out, std::string& error);
+
+// Prints the throughput of `current` against `baseline`, per position and
+// in total. Returns true if total nodes/sec dropped by more than
+// `threshold_pct` percent, or if a position allocates more than it did in
+// the baseline (when both were taken with ALLOC_STATS).
+bool report_bench_regression(std::ostream& out, const BenchReport& current,
+                             const BenchReport& baseline, double threshold_pct);
+
+} // namespace chess
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+
+#include "chess/types.h"
+
+namespace chess {
+
+// ------------------------------------------------------------
+// Bitboards
+// One bit per square, using the same indexing as Square:
+//   bit 0 = a1, bit 7 = h1, bit 56 = a8, bit 63 = h8
+// ------------------------------------------------------------
+
+using Bitboard = std::uint64_t;
+
+constexpr Bitboard BB_EMPTY = 0;
+constexpr Bitboard BB_ALL   = ~Bitboard{0};
+
+constexpr Bitboard FILE_A_BB = 0x0101010101010101ull;
+constexpr Bitboard FILE_H_BB = FILE_A_BB << 7;
+constexpr Bitboard RANK_1_BB = 0xFFull;
+constexpr Bitboard RANK_8_BB = RANK_1_BB << 56;
+
+constexpr Bitboard file_bb(int file) { return FILE_A_BB << file; }
+constexpr Bitboard rank_bb(int rank) { return RANK_1_BB << (8 * rank); }
+
+constexpr Bitboard square_bb(int sq) { return Bitboard{1} << sq; }
+
+constexpr bool test_bit(Bitboard b, int sq) { return (b >> sq) & 1; }
+
+constexpr int popcount(Bitboard b) { return std::popcount(b); }
+
+// Index of the least significant set bit. Undefined for b == 0.
+constexpr int lsb(Bitboard b) { return std::countr_zero(b); }
+
+// Removes and returns the least significant set bit. Undefined for b == 0.
+constexpr int pop_lsb(Bitboard& b) {
+    const int sq = lsb(b);
+    b &= b - 1;
+    return sq;
+}
+
+} // namespace chess
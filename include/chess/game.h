@@ -40,7 +40,7 @@ public:
 
     // History
     size_t ply() const { return moves_.size(); }
-    const std::vector<Move>& moves() const { return moves_; }
+    const std::vector<PackedMove>& moves() const { return moves_; }
 
     // Draw detection helpers (automatic 3-fold + 50-move)
     int repetition_count_current() const;
@@ -58,7 +58,7 @@ public:
 private:
     Position pos_;
 
-    std::vector<Move> moves_;
+    std::vector<PackedMove> moves_;
     std::vector<Undo> undos_;
 
     // Zobrist history: includes the key for the *current* position as keys_.back()
@@ -66,8 +66,6 @@ private:
 
     std::array<PlayerType, 2> players_{ PlayerType::Human, PlayerType::Human };
     std::array<AiMoveFn, 2> ai_{}; // empty std::function by default
-
-    static bool same_move(const Move& a, const Move& b);
 };
 
 } // namespace chess
\ No newline at end of file
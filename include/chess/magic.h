@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstdint>
+
+#include "chess/bitboard.h"
+
+// PEXT is reachable on x86-64 only. With -mbmi2 the intrinsic is used
+// directly; otherwise GCC/Clang refuse to inline the intrinsic into
+// generic code, so the instruction is emitted via inline asm and only
+// executed once CPUID has confirmed BMI2 support.
+#if defined(__x86_64__) || defined(_M_X64)
+    #define CHESS_PEXT_AVAILABLE 1
+    #if defined(__BMI2__) || defined(_MSC_VER)
+        #include <immintrin.h>
+    #endif
+#else
+    #define CHESS_PEXT_AVAILABLE 0
+#endif
+
+namespace chess {
+
+// ------------------------------------------------------------
+// Magic bitboards for sliding pieces.
+//
+// For each square, the relevant blockers (the slider's rays without the
+// board edge) are multiplied by a "magic" constant; the top bits of the
+// product index a table holding the attack set for that occupancy.
+//
+// Magics are searched once at program startup with a fixed-seed PRNG, so
+// the tables (and the magics themselves) are identical on every run.
+//
+// On CPUs with BMI2 the same tables can instead be indexed with PEXT
+// (parallel bit extract of the occupancy under the mask), which needs no
+// multiply/shift. The backend is picked at startup via CPUID and the
+// tables are laid out for whichever indexing scheme is active.
+// ------------------------------------------------------------
+
+enum class SliderBackend : std::uint8_t { Magic, Pext };
+
+struct Magic {
+    Bitboard  mask  = 0;       // relevant occupancy (rays minus edges)
+    Bitboard  magic = 0;
+    Bitboard* attacks = nullptr; // slice of the shared attack table
+    unsigned  shift = 0;       // 64 - popcount(mask)
+
+    unsigned index(Bitboard occupied) const {
+        return static_cast<unsigned>(((occupied & mask) * magic) >> shift);
+    }
+};
+
+extern Magic rook_magics[64];
+extern Magic bishop_magics[64];
+
+namespace detail {
+
+extern bool slider_use_pext; // true when tables are laid out for PEXT
+
+inline Bitboard pext(Bitboard b, Bitboard mask) {
+#if defined(__BMI2__) || defined(_MSC_VER)
+    return _pext_u64(b, mask);
+#elif CHESS_PEXT_AVAILABLE
+    Bitboard r;
+    __asm__("pextq %2, %1, %0" : "=r"(r) : "r"(b), "r"(mask));
+    return r;
+#else
+    (void)b; (void)mask;
+    return 0; // unreachable: PEXT backend is never selected
+#endif
+}
+
+inline unsigned slider_index(const Magic& m, Bitboard occupied) {
+#if CHESS_PEXT_AVAILABLE
+    if (slider_use_pext) return static_cast<unsigned>(pext(occupied, m.mask));
+#endif
+    return m.index(occupied);
+}
+
+} // namespace detail
+
+inline Bitboard rook_attacks(int sq, Bitboard occupied) {
+    const Magic& m = rook_magics[sq];
+    return m.attacks[detail::slider_index(m, occupied)];
+}
+
+inline Bitboard bishop_attacks(int sq, Bitboard occupied) {
+    const Magic& m = bishop_magics[sq];
+    return m.attacks[detail::slider_index(m, occupied)];
+}
+
+inline Bitboard queen_attacks(int sq, Bitboard occupied) {
+    return rook_attacks(sq, occupied) | bishop_attacks(sq, occupied);
+}
+
+// True if the running CPU supports BMI2 (and this build can emit PEXT).
+bool cpu_has_bmi2();
+
+// Backend currently used by rook_attacks/bishop_attacks.
+SliderBackend slider_backend();
+const char* slider_backend_name(SliderBackend b);
+
+// Switches backend and rebuilds the attack tables for its indexing scheme.
+// Returns false (and changes nothing) if PEXT is requested but unsupported.
+// Not thread-safe: call before any concurrent move generation.
+bool set_slider_backend(SliderBackend b);
+
+// Reference implementation (ray walk), used to build and verify the
+// tables. constexpr so that compile-time tables can use it too.
+constexpr Bitboard sliding_attacks_slow(int sq, Bitboard occupied, bool rook) {
+    constexpr int rdf[4] = {  1, -1,  0,  0 };
+    constexpr int rdr[4] = {  0,  0,  1, -1 };
+    constexpr int bdf[4] = {  1,  1, -1, -1 };
+    constexpr int bdr[4] = {  1, -1,  1, -1 };
+
+    const int* df = rook ? rdf : bdf;
+    const int* dr = rook ? rdr : bdr;
+
+    Bitboard attacks = 0;
+    for (int d = 0; d < 4; ++d) {
+        int f = file_of(sq) + df[d];
+        int r = rank_of(sq) + dr[d];
+        while (f >= 0 && f < 8 && r >= 0 && r < 8) {
+            const int to = make_square(f, r);
+            attacks |= square_bb(to);
+            if (test_bit(occupied, to)) break;
+            f += df[d];
+            r += dr[d];
+        }
+    }
+    return attacks;
+}
+
+} // namespace chess
@@ -37,6 +37,73 @@ constexpr bool is_en_passant(const Move& m)  { return (m.flags & MF_EN_PASSANT)
 constexpr bool is_castle(const Move& m)      { return (m.flags & MF_CASTLE) != 0; }
 constexpr bool is_double_push(const Move& m) { return (m.flags & MF_DOUBLE_PUSH) != 0; }
 
+// Kind of a packed move (4 bits): bit 2 = capture, bit 3 = promotion, and
+// for promotions the low two bits give the piece (N, B, R, Q). 6 and 7 are
+// unused.
+enum MoveKind : uint8_t {
+    MK_QUIET                = 0,
+    MK_DOUBLE_PUSH          = 1,
+    MK_KING_CASTLE          = 2,
+    MK_QUEEN_CASTLE         = 3,
+    MK_CAPTURE              = 4,
+    MK_EN_PASSANT           = 5,
+    MK_PROMO_KNIGHT         = 8,
+    MK_PROMO_BISHOP         = 9,
+    MK_PROMO_ROOK           = 10,
+    MK_PROMO_QUEEN          = 11,
+    MK_PROMO_KNIGHT_CAPTURE = 12,
+    MK_PROMO_BISHOP_CAPTURE = 13,
+    MK_PROMO_ROOK_CAPTURE   = 14,
+    MK_PROMO_QUEEN_CAPTURE  = 15
+};
+
+// Move packed into 16 bits (from: bits 0-5, to: 6-11, kind: 12-15), the
+// form moves are stored in: move lists and game history. Converts to Move
+// implicitly and back without loss, so code working on Move takes it as is.
+class PackedMove {
+public:
+    constexpr PackedMove() = default;
+    constexpr PackedMove(int from, int to, MoveKind kind)
+        : bits_(static_cast<uint16_t>(from | (to << 6) | (kind << 12))) {}
+    constexpr explicit PackedMove(const Move& m) : PackedMove(m.from, m.to, kind_of(m)) {}
+
+    constexpr int from() const { return bits_ & 63; }
+    constexpr int to() const { return (bits_ >> 6) & 63; }
+    constexpr MoveKind kind() const { return static_cast<MoveKind>(bits_ >> 12); }
+    constexpr uint16_t raw() const { return bits_; }
+
+    constexpr bool is_capture() const { return (kind() & MK_CAPTURE) != 0; }
+    constexpr bool is_promotion() const { return (kind() & MK_PROMO_KNIGHT) != 0; }
+    constexpr PieceType promo() const {
+        return is_promotion() ? static_cast<PieceType>(PT_KNIGHT + (kind() & 3)) : PT_NONE;
+    }
+
+    constexpr operator Move() const {
+        return Move(static_cast<uint8_t>(from()), static_cast<uint8_t>(to()), FLAGS[kind()], promo());
+    }
+
+    friend constexpr bool operator==(PackedMove a, PackedMove b) { return a.bits_ == b.bits_; }
+
+private:
+    static constexpr uint8_t FLAGS[16] = {
+        MF_NONE, MF_DOUBLE_PUSH, MF_CASTLE, MF_CASTLE, MF_CAPTURE, MF_EN_PASSANT | MF_CAPTURE, MF_NONE, MF_NONE,
+        MF_PROMOTION, MF_PROMOTION, MF_PROMOTION, MF_PROMOTION,
+        MF_PROMOTION | MF_CAPTURE, MF_PROMOTION | MF_CAPTURE, MF_PROMOTION | MF_CAPTURE, MF_PROMOTION | MF_CAPTURE,
+    };
+
+    static constexpr MoveKind kind_of(const Move& m) {
+        const int capture = (m.flags & MF_CAPTURE) ? MK_CAPTURE : 0;
+        if (m.flags & MF_PROMOTION) return static_cast<MoveKind>(MK_PROMO_KNIGHT | capture | ((m.promo - PT_KNIGHT) & 3));
+        if (m.flags & MF_EN_PASSANT) return MK_EN_PASSANT;
+        if (m.flags & MF_CASTLE) return m.to > m.from ? MK_KING_CASTLE : MK_QUEEN_CASTLE;
+        if (m.flags & MF_DOUBLE_PUSH) return MK_DOUBLE_PUSH;
+        return static_cast<MoveKind>(capture);
+    }
+
+    uint16_t bits_ = 0;
+};
+static_assert(sizeof(PackedMove) == 2);
+
 // UCI format:
 //  - normal: "e2e4"
 //  - promotion: "e7e8q" (always lower-case in UCI)
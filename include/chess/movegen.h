@@ -1,16 +1,38 @@
 #pragma once
 
+#include <optional>
 #include <vector>
 
 #include "chess/position.h"
 #include "chess/move.h"
+#include "chess/movelist.h"
 
 namespace chess {
 
 // Generate pseudo-legal moves for side to move (may leave king in check).
-void generate_pseudo_legal(const Position& pos, std::vector<Move>& out);
+void generate_pseudo_legal(const Position& pos, MoveList& out);
+
+// Generate legal moves for side to move.
+// Checkers and pins are computed once up front, so only legal moves are ever
+// produced (no make/undo per candidate).
+void generate_legal(const Position& pos, MoveList& out);
+
+// Number of legal moves for side to move, counted from the same masks as
+// generate_legal without storing any move (each promotion counts 4).
+int count_legal(const Position& pos);
 
-// Generate legal moves for side to move (filters out moves that leave king in check).
-void generate_legal(Position& pos, std::vector<Move>& out);
+// True if side to move has any legal move; returns at the first one found.
+bool has_legal_move(const Position& pos);
+
+// Looks up m's from/to/promo (flags are ignored) for side to move without
+// generating a list: returns the move with its position-derived flags
+// (capture, en passant, castle, double push) if legal, nullopt otherwise.
+std::optional<Move> resolve_move(const Position& pos, const Move& m);
+bool is_legal(const Position& pos, const Move& m);
+
+// std::vector overloads, kept for callers that want an owning container.
+// Hot paths should use MoveList, which never allocates.
+void generate_pseudo_legal(const Position& pos, std::vector<Move>& out);
+void generate_legal(const Position& pos, std::vector<Move>& out);
 
 } // namespace chess
\ No newline at end of file
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <new>
+
+#include "chess/move.h"
+
+namespace chess {
+
+// Fixed-capacity move buffer that lives on the stack.
+// 256 entries covers every reachable position (the known maximum is 218
+// legal moves), so generation never touches the heap. Moves are stored
+// packed (512 bytes for the whole buffer) and convert to Move on use.
+//
+// Storage is left uninitialized; only the first size() entries are valid.
+class MoveList {
+public:
+    static constexpr std::size_t kCapacity = 256;
+
+    MoveList() = default;
+    MoveList(const MoveList& other) : size_(other.size_) {
+        for (std::size_t i = 0; i < size_; ++i) ::new (slot(i)) PackedMove(other[i]);
+    }
+    MoveList& operator=(const MoveList& other) {
+        size_ = other.size_;
+        for (std::size_t i = 0; i < size_; ++i) ::new (slot(i)) PackedMove(other[i]);
+        return *this;
+    }
+
+    void push_back(PackedMove m) {
+        assert(size_ < kCapacity);
+        ::new (slot(size_++)) PackedMove(m);
+    }
+    void push_back(const Move& m) { push_back(PackedMove(m)); }
+
+    void emplace_back(int from, int to, MoveKind kind = MK_QUIET) {
+        assert(size_ < kCapacity);
+        ::new (slot(size_++)) PackedMove(from, to, kind);
+    }
+
+    void clear() { size_ = 0; }
+
+    std::size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    PackedMove* data() { return std::launder(reinterpret_cast<PackedMove*>(storage_)); }
+    const PackedMove* data() const { return std::launder(reinterpret_cast<const PackedMove*>(storage_)); }
+
+    PackedMove& operator[](std::size_t i) { return data()[i]; }
+    const PackedMove& operator[](std::size_t i) const { return data()[i]; }
+
+    PackedMove* begin() { return data(); }
+    PackedMove* end() { return data() + size_; }
+    const PackedMove* begin() const { return data(); }
+    const PackedMove* end() const { return data() + size_; }
+
+private:
+    void* slot(std::size_t i) { return storage_ + i * sizeof(PackedMove); }
+
+    alignas(PackedMove) unsigned char storage_[kCapacity * sizeof(PackedMove)];
+    std::size_t size_ = 0;
+};
+
+} // namespace chess
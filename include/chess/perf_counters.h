@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace chess {
+
+enum PerfEvent : int {
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_BRANCH_MISSES,
+    PERF_L1D_MISSES,
+    PERF_LLC_MISSES,
+    PERF_EVENT_COUNT
+};
+
+const char* perf_event_name(PerfEvent e);
+
+// Counter values of one measurement; an event the machine (or the
+// kernel's perf_event_paranoid setting) doesn't allow is simply missing.
+struct PerfReading {
+    std::uint64_t value[PERF_EVENT_COUNT] = {};
+    bool has[PERF_EVENT_COUNT] = {};
+
+    bool any() const;
+
+    // "IPC 2.41  cycles/node 38.1  branch-misses/node 0.21 ..." for the
+    // events present; empty if none are.
+    std::string per_node(std::uint64_t nodes, const char* unit = "node") const;
+};
+
+// Hardware counters (Linux perf_event_open) for the calling thread and any
+// threads it starts while counting, user space only. Elsewhere, or when
+// the kernel refuses, available() is false and readings are empty, so
+// callers never need a separate code path.
+class PerfCounters {
+public:
+    PerfCounters();
+    ~PerfCounters();
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    bool available() const;
+    // Why no counter could be opened (empty when available).
+    const std::string& error() const { return error_; }
+
+    void start();
+    PerfReading stop();
+
+private:
+    int fds_[PERF_EVENT_COUNT];
+    std::string error_;
+};
+
+} // namespace chess
@@ -1,15 +1,38 @@
 #pragma once
 
 #include <cstdint>
+#include <utility>
+#include <vector>
 
+#include "chess/move.h"
+#include "chess/perft_table.h"
 #include "chess/position.h"
 
 namespace chess {
 
 // Counts leaf nodes to `depth` using legal move generation.
-uint64_t perft(Position& pos, int depth);
+// If `table` is given (and enabled), subtree counts at depth >= 2 are
+// looked up and stored there, so transpositions are only counted once.
+uint64_t perft(Position& pos, int depth, PerftTable* table = nullptr);
+
+// Node counts for every depth 1..max_depth from a single traversal:
+// result[d - 1] == perft(pos, d). Costs the same as perft(pos, max_depth),
+// since the shallower counts are the interior nodes it visits anyway.
+std::vector<uint64_t> perft_by_depth(Position& pos, int max_depth);
 
 // Like perft, but prints each root move with its node count (useful for debugging).
-uint64_t perft_divide(Position& pos, int depth);
+uint64_t perft_divide(Position& pos, int depth, PerftTable* table = nullptr, unsigned threads = 1);
+
+// Multi-threaded perft; always returns exactly perft(pos, depth).
+// Subtrees below the root moves run on a work-stealing pool of `threads`
+// workers. When the root has too few moves to keep every thread busy
+// (typical in endgames), the split is pushed down to deeper plies.
+// `table`, if given, is shared by all threads.
+uint64_t perft_parallel(const Position& pos, int depth, unsigned threads, PerftTable* table = nullptr);
+
+// Node count below each root move, in generate_legal order (what divide prints).
+std::vector<std::pair<Move, uint64_t>> perft_divide_counts(const Position& pos, int depth,
+                                                           unsigned threads = 1,
+                                                           PerftTable* table = nullptr);
 
 } // namespace chess
\ No newline at end of file
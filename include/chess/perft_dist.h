@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "chess/position.h"
+
+namespace chess {
+
+// One subtree of a distributed perft run: the position reached from the
+// root by `path` (UCI moves joined by '.', "-" for the root itself),
+// to be searched to `depth`.
+struct PerftSubtree {
+    std::string path;
+    std::string fen;
+    int depth = 0;
+};
+
+// Every position `split_depth` plies below `pos` as a subtree of depth
+// `depth - split_depth`, in generate_legal order. split_depth is clamped
+// to [0, depth - 1]. The list is deterministic for a given root, which is
+// what lets a checkpoint refer to subtrees by path.
+std::vector<PerftSubtree> split_perft_subtrees(const Position& pos, int depth, int split_depth);
+
+struct DistributedPerftOptions {
+    unsigned workers = 1;
+    int split_depth = 2;
+    std::string checkpoint;  // file of finished subtrees; empty disables
+    std::size_t hash_mb = 0; // perft table per worker process
+    bool progress = false;   // one line per finished subtree on stderr
+};
+
+struct DistributedPerftResult {
+    bool ok = false;
+    std::string error;
+    uint64_t nodes = 0;
+    std::size_t subtrees = 0;
+    std::size_t resumed = 0; // subtrees already in the checkpoint
+    std::vector<std::pair<std::string, uint64_t>> divide; // per root move, UCI
+};
+
+// perft(pos, depth) computed by forked worker processes.
+//
+// The coordinator splits the tree with split_perft_subtrees and hands one
+// subtree at a time to each worker over a Unix socket pair (as FEN and
+// depth). Each finished count is appended to the checkpoint and flushed
+// before the next subtree is handed out, so a run that is killed loses at
+// most the subtrees in flight; rerunning with the same root, depth, split
+// depth and checkpoint picks up the rest.
+//
+// POSIX only. Call it before starting any threads of your own.
+DistributedPerftResult perft_distributed(const Position& pos, int depth,
+                                         const DistributedPerftOptions& opts);
+
+} // namespace chess
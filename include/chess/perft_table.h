@@ -0,0 +1,76 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace chess {
+
+// Hash table of perft subtree counts keyed by (Zobrist key, depth).
+//
+// Entries store the full 64-bit key, so a hit needs a genuine 64-bit
+// Zobrist collision to be wrong (the index only uses the low bits).
+// Each entry is written as (key ^ data, data) with relaxed atomics; a
+// torn or concurrent write fails the key check on probe and reads as a
+// miss, so the table may be shared between threads without locks.
+//
+// The table can also live in a memory-mapped file (open_file), which
+// keeps results across runs and shares them between processes the same
+// way it shares them between threads.
+class PerftTable {
+public:
+    PerftTable() = default;
+    explicit PerftTable(std::size_t mb) { resize(mb); }
+    ~PerftTable();
+
+    PerftTable(const PerftTable&) = delete;
+    PerftTable& operator=(const PerftTable&) = delete;
+
+    // Reallocates to the largest power-of-two bucket count fitting in `mb`
+    // megabytes and clears it. 0 disables the table.
+    void resize(std::size_t mb);
+
+    // Maps `path` as the table, creating it with room for `mb` megabytes if
+    // needed; an existing file keeps its own size. A file written by a
+    // build with a different move generator is wiped rather than trusted.
+    // On failure the table is left disabled and `error` says why.
+    bool open_file(const std::string& path, std::size_t mb, std::string& error);
+
+    void clear();
+
+    bool enabled() const { return bucket_count_ != 0; }
+    bool persistent() const { return map_ != nullptr; }
+    std::size_t size_mb() const { return (bucket_count_ * sizeof(Bucket)) >> 20; }
+
+    bool probe(std::uint64_t key, int depth, std::uint64_t& nodes) const;
+    void store(std::uint64_t key, int depth, std::uint64_t nodes);
+
+private:
+    // data = nodes << 8 | depth
+    struct Entry {
+        std::atomic<std::uint64_t> check{0}; // key ^ data
+        std::atomic<std::uint64_t> data{0};
+    };
+
+    // Four entries per 64-byte cache line.
+    struct alignas(64) Bucket {
+        Entry entries[4];
+    };
+
+    const Bucket& bucket(std::uint64_t key) const { return buckets_[key & (bucket_count_ - 1)]; }
+    Bucket& bucket(std::uint64_t key) { return buckets_[key & (bucket_count_ - 1)]; }
+
+    void release();
+
+    std::unique_ptr<Bucket[]> heap_;
+    void* map_ = nullptr; // file mapping: header followed by the buckets
+    std::size_t map_bytes_ = 0;
+
+    Bucket* buckets_ = nullptr;
+    std::size_t bucket_count_ = 0;
+    std::uint64_t salt_ = 0; // xor-ed into keys of a file table, see open_file
+};
+
+} // namespace chess
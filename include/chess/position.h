@@ -4,7 +4,9 @@
 #include <cstdint>
 #include <string>
 
+#include "chess/bitboard.h"
 #include "chess/types.h"
+#include "chess/zobrist.h"
 
 namespace chess {
 
@@ -20,13 +22,22 @@ public:
     void  set_piece(int sq, Piece p);
 
     Color side_to_move() const { return stm_; }
-    void  set_side_to_move(Color c) { stm_ = c; }
+    void  set_side_to_move(Color c) {
+        if (c != stm_) key_ ^= zobrist_side();
+        stm_ = c;
+    }
 
     uint8_t castling_rights() const { return castling_; }
-    void    set_castling_rights(uint8_t rights) { castling_ = rights; }
+    void    set_castling_rights(uint8_t rights) {
+        key_ ^= zobrist_castling(castling_) ^ zobrist_castling(rights);
+        castling_ = rights;
+    }
 
     Square ep_square() const { return ep_sq_; }
-    void   set_ep_square(Square sq) { ep_sq_ = sq; }
+    void   set_ep_square(Square sq) {
+        key_ ^= zobrist_ep(ep_sq_) ^ zobrist_ep(sq);
+        ep_sq_ = sq;
+    }
 
     uint16_t halfmove_clock() const { return halfmove_; }
     void     set_halfmove_clock(uint16_t hm) { halfmove_ = hm; }
@@ -34,6 +45,17 @@ public:
     uint16_t fullmove_number() const { return fullmove_; }
     void     set_fullmove_number(uint16_t fm) { fullmove_ = fm; }
 
+    // Occupancy bitboards (always kept in sync with the mailbox by set_piece)
+    Bitboard by_type(PieceType pt) const { return by_type_[pt]; }
+    Bitboard by_color(Color c) const { return by_color_[c]; }
+    Bitboard pieces(Color c, PieceType pt) const { return by_color_[c] & by_type_[pt]; }
+    Bitboard occupied() const { return by_color_[WHITE] | by_color_[BLACK]; }
+
+    // Zobrist key, updated incrementally by every setter above and by
+    // set_piece. Always equals zobrist_key(*this).
+    std::uint64_t key() const { return key_; }
+    void set_key(std::uint64_t k) { key_ = k; } // for undo_move restoring a saved key
+
     // King square helpers (cached)
     int king_square(Color c) const { return king_sq_[c]; }
     void set_king_square(Color c, int sq) { king_sq_[c] = sq; }
@@ -45,6 +67,11 @@ public:
 private:
     std::array<Piece, 64> board_{};
 
+    // Bitboards mirroring board_: one per piece type (indexed by PieceType,
+    // PT_NONE unused) and one per color.
+    std::array<Bitboard, 7> by_type_{};
+    std::array<Bitboard, 2> by_color_{};
+
     Color   stm_      = WHITE;
     uint8_t castling_ = CASTLE_NONE;
     Square  ep_sq_    = -1;
@@ -54,6 +81,8 @@ private:
     // Cache king squares for fast check detection later.
     // Always keep updated when setting pieces / making moves.
     std::array<uint8_t, 2> king_sq_{0, 0};
+
+    std::uint64_t key_ = 0;
 };
 
 } // namespace chess
\ No newline at end of file
@@ -15,6 +15,11 @@ enum class GameResult {
 
 bool in_check(const Position& pos, Color side);
 
+// Side to move is in check / not in check and has no legal move.
+// Neither builds a move list.
+bool is_checkmate(const Position& pos);
+bool is_stalemate(const Position& pos);
+
 // repetition_count is how many times the *current* position has appeared in the game history.
 // (If you treat 3-fold as automatic draw, you’ll pass the computed count from Game.)
 GameResult result(const Position& pos, int repetition_count);
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace chess {
+
+// Call counters for the move generator's hot paths.
+//
+// Compiled in only with -DCHESS_STATS (`make STATS=1`); otherwise
+// CHESS_STAT() expands to nothing and the totals stay zero. Each thread
+// counts into its own cache-line-sized block, so counting never contends;
+// stats_snapshot() sums the blocks on demand.
+
+enum Stat : int {
+    STAT_GENERATE_LEGAL,
+    STAT_COUNT_LEGAL,
+    STAT_GENERATE_PSEUDO_LEGAL,
+    STAT_MAKE_MOVE,
+    STAT_UNDO_MOVE,
+    STAT_IS_SQUARE_ATTACKED,
+    STAT_ZOBRIST_KEY,
+    STAT_ILLEGAL_REJECTED, // candidate moves the legal generator tested and dropped
+    STAT_COUNT
+};
+
+using StatCounts = std::array<std::uint64_t, STAT_COUNT>;
+
+#ifdef CHESS_STATS
+inline constexpr bool stats_enabled = true;
+#else
+inline constexpr bool stats_enabled = false;
+#endif
+
+const char* stat_name(Stat s);
+
+// Totals over all threads, including threads that have exited.
+StatCounts stats_snapshot();
+void stats_reset();
+
+#ifdef CHESS_STATS
+
+namespace detail {
+
+struct alignas(64) StatBlock {
+    std::atomic<std::uint64_t> count[STAT_COUNT] = {};
+};
+static_assert(sizeof(StatBlock) == 64);
+
+extern constinit thread_local StatBlock* tl_stats;
+StatBlock* register_stats_thread();
+
+// Only the owning thread writes its block, so a plain load/store pair is
+// enough (no locked read-modify-write).
+inline void stat_bump(Stat s) {
+    StatBlock* block = tl_stats;
+    if (!block) block = register_stats_thread();
+    std::atomic<std::uint64_t>& c = block->count[s];
+    c.store(c.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+} // namespace detail
+
+#define CHESS_STAT(s) ::chess::detail::stat_bump(::chess::s)
+
+#else
+
+#define CHESS_STAT(s) ((void)0)
+
+#endif
+
+} // namespace chess
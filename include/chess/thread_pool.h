@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace chess {
+
+// Small work-stealing thread pool.
+//
+// Every worker owns a deque. Tasks submitted from a worker go to the back
+// of its own deque (and are popped from there, LIFO); tasks submitted from
+// outside are dealt round-robin. An idle worker steals from the front of
+// the other deques, which holds the oldest and usually largest tasks.
+class ThreadPool {
+public:
+    using Task = std::function<void()>;
+
+    explicit ThreadPool(unsigned threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Queues are all created before any worker starts, so workers may read this.
+    unsigned size() const { return static_cast<unsigned>(queues_.size()); }
+
+    void submit(Task task);
+
+    // Blocks until every submitted task (including tasks submitted by
+    // tasks) has finished.
+    void wait();
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void worker_loop(unsigned id);
+    bool try_pop(unsigned id, Task& out);
+
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> workers_;
+
+    std::mutex mutex_;                  // guards sleeping/waking and stop_
+    std::condition_variable work_cv_;
+    std::condition_variable done_cv_;
+    std::atomic<std::size_t> queued_{0};  // tasks sitting in a deque
+    std::atomic<std::size_t> pending_{0}; // tasks submitted but not finished
+    std::atomic<unsigned> next_queue_{0};
+    bool stop_ = false;
+};
+
+// Number of hardware threads, at least 1.
+unsigned hardware_threads();
+
+} // namespace chess
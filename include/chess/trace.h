@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace chess {
+
+// Timeline tracer writing Chrome trace-event JSON (chrome://tracing,
+// https://ui.perfetto.dev).
+//
+// Off by default: a TraceScope then costs one relaxed load. While on, each
+// thread records finished scopes into its own ring buffer, which keeps the
+// newest TRACE_RING_EVENTS events; the rings are merged only when the
+// trace is written. Meant for coarse work items (perft root moves, suite
+// cases, AI moves), not for per-node calls.
+
+inline constexpr std::size_t TRACE_RING_EVENTS = 1 << 14;
+
+// Starts a new trace that trace_stop() (or process exit) writes to path.
+// Fails if path cannot be written.
+bool trace_start(const std::string& path, std::string& error);
+
+// Writes the trace and stops recording. Scopes still open on other threads
+// are not included.
+bool trace_stop(std::string& error);
+
+// Labels the calling thread in the timeline (no-op while not tracing).
+void trace_thread_name(const std::string& name);
+
+namespace detail {
+
+extern std::atomic<bool> trace_on;
+
+void trace_record(const char* name, const char* detail, std::chrono::steady_clock::time_point begin);
+
+} // namespace detail
+
+inline bool trace_enabled() {
+    return detail::trace_on.load(std::memory_order_relaxed);
+}
+
+// Records the time from construction to destruction as one event named
+// `name` (which must outlive the trace, e.g. a string literal), with an
+// optional short detail shown in the viewer's args (truncated to 31 chars).
+class TraceScope {
+public:
+    explicit TraceScope(const char* name, std::string_view detail = {}) : name_(enabled_name(name)) {
+        if (name_) {
+            set_detail(detail);
+            begin_ = std::chrono::steady_clock::now();
+        }
+    }
+
+    ~TraceScope() {
+        if (name_) detail::trace_record(name_, detail_, begin_);
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+    void set_detail(std::string_view detail) {
+        if (!name_) return;
+        const std::size_t n = detail.size() < sizeof(detail_) - 1 ? detail.size() : sizeof(detail_) - 1;
+        detail.copy(detail_, n);
+        detail_[n] = '\0';
+    }
+
+private:
+    static const char* enabled_name(const char* name) { return trace_enabled() ? name : nullptr; }
+
+    const char* name_;
+    char detail_[32] = {};
+    std::chrono::steady_clock::time_point begin_{};
+};
+
+} // namespace chess
@@ -73,6 +73,12 @@ constexpr int flip_rank(int sq) {
 
 constexpr Color opposite(Color c) { return c ^ 1; }
 
+// Colour-relative squares. Called with a compile-time colour (a
+// `template <Color Us>` parameter) they fold to constants.
+constexpr int pawn_push(Color c) { return c == WHITE ? 8 : -8; }
+constexpr int relative_rank(Color c, int rank) { return c == WHITE ? rank : 7 - rank; }
+constexpr int relative_square(Color c, int sq) { return c == WHITE ? sq : flip_rank(sq); }
+
 // ------------------------------------------------------------
 // Piece helpers
 // ------------------------------------------------------------
@@ -96,6 +102,10 @@ constexpr PieceType piece_type(Piece p) {
     }
 }
 
+constexpr Piece make_piece(Color c, PieceType pt) {
+    return static_cast<Piece>(c == WHITE ? pt : pt + 6); // black pieces are offset by +6
+}
+
 constexpr bool is_slider(Piece p) {
     const auto t = piece_type(p);
     return t == PT_BISHOP || t == PT_ROOK || t == PT_QUEEN;
@@ -13,6 +13,7 @@ struct Undo {
     Square ep_square = -1;       // previous en-passant square
     uint16_t halfmove_clock = 0; // previous halfmove clock
     uint16_t fullmove_number = 1;// previous fullmove number (optional but safe)
+    uint64_t key = 0;            // previous Zobrist key
 };
 
 } // namespace chess
\ No newline at end of file
@@ -1,12 +1,34 @@
 #pragma once
 
+#include <array>
 #include <cstdint>
-#include "chess/position.h"
+
+#include "chess/types.h"
 
 namespace chess {
 
-// Compute a 64-bit Zobrist key for the position.
+class Position;
+
+// Random keys XORed together to form a position hash.
+struct ZobristKeys {
+    std::array<std::array<std::uint64_t, 64>, 13> piece{}; // [piece][square], EMPTY row unused
+    std::array<std::uint64_t, 16> castling{};               // castling rights bitmask 0..15
+    std::array<std::uint64_t, 9> ep_file{};                 // 0..7 for file, 8 = none
+    std::uint64_t side = 0;                                 // toggled when black to move
+};
+
+extern const ZobristKeys zobrist_keys;
+
+// Per-feature keys, used by Position to update its key incrementally.
+inline std::uint64_t zobrist_piece(Piece p, int sq) { return zobrist_keys.piece[p][sq]; }
+inline std::uint64_t zobrist_castling(uint8_t rights) { return zobrist_keys.castling[rights & 0x0F]; }
+inline std::uint64_t zobrist_ep(Square ep) { return zobrist_keys.ep_file[ep == -1 ? 8 : file_of(ep)]; }
+inline std::uint64_t zobrist_side() { return zobrist_keys.side; }
+
+// Compute a 64-bit Zobrist key for the position from scratch.
 // Includes: pieces, side to move, castling rights, en-passant (file), etc.
+// Position::key() maintains the same value incrementally; this full
+// recompute is the reference it is checked against.
 std::uint64_t zobrist_key(const Position& pos);
 
-} // namespace chess
\ No newline at end of file
+} // namespace chess
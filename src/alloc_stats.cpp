@@ -0,0 +1,132 @@
+#include "chess/alloc_stats.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+namespace chess {
+
+#ifdef CHESS_ALLOC_STATS
+
+namespace {
+
+// Plain relaxed counters: the build is for measuring allocation rates, and
+// an allocation costs far more than the increments.
+std::atomic<std::uint64_t> g_allocations{0};
+std::atomic<std::uint64_t> g_bytes{0};
+std::atomic<std::uint64_t> g_frees{0};
+
+void* allocate(std::size_t size, std::size_t align) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    g_bytes.fetch_add(size, std::memory_order_relaxed);
+
+    if (size == 0) size = 1;
+    // aligned_alloc wants a multiple of the alignment.
+    if (align > alignof(std::max_align_t)) size = (size + align - 1) / align * align;
+    while (true) {
+        void* p = align > alignof(std::max_align_t) ? std::aligned_alloc(align, size) : std::malloc(size);
+        if (p) return p;
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) return nullptr;
+        handler();
+    }
+}
+
+void* allocate_or_throw(std::size_t size, std::size_t align) {
+    void* p = allocate(size, align);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+// For the nothrow forms, which must return nullptr even when the
+// new_handler gives up by throwing.
+void* allocate_nothrow(std::size_t size, std::size_t align) noexcept {
+    try {
+        return allocate(size, align);
+    } catch (const std::bad_alloc&) {
+        return nullptr;
+    }
+}
+
+void deallocate(void* p) {
+    if (!p) return;
+    g_frees.fetch_add(1, std::memory_order_relaxed);
+    std::free(p);
+}
+
+} // namespace
+
+AllocCounts alloc_counts() {
+    AllocCounts c;
+    c.allocations = g_allocations.load(std::memory_order_relaxed);
+    c.bytes = g_bytes.load(std::memory_order_relaxed);
+    c.frees = g_frees.load(std::memory_order_relaxed);
+    return c;
+}
+
+#else
+
+AllocCounts alloc_counts() {
+    return {};
+}
+
+#endif
+
+AllocCounts operator-(const AllocCounts& a, const AllocCounts& b) {
+    return { a.allocations - b.allocations, a.bytes - b.bytes, a.frees - b.frees };
+}
+
+std::string AllocCounts::per_node(std::uint64_t nodes, const char* unit) const {
+    if (!alloc_stats_enabled) return {};
+    const double n = nodes ? static_cast<double>(nodes) : 1.0;
+    char buf[96];
+    std::snprintf(buf, sizeof(buf), "allocs/%s %.3f  bytes/%s %.1f", unit,
+                  static_cast<double>(allocations) / n, unit, static_cast<double>(bytes) / n);
+    return buf;
+}
+
+} // namespace chess
+
+#ifdef CHESS_ALLOC_STATS
+
+// Replacements for every global allocation function (C++17 set).
+constexpr std::size_t DEFAULT_ALIGN = alignof(std::max_align_t);
+
+void* operator new(std::size_t size) { return chess::allocate_or_throw(size, DEFAULT_ALIGN); }
+void* operator new[](std::size_t size) { return chess::allocate_or_throw(size, DEFAULT_ALIGN); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return chess::allocate_nothrow(size, DEFAULT_ALIGN);
+}
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return chess::allocate_nothrow(size, DEFAULT_ALIGN);
+}
+
+void* operator new(std::size_t size, std::align_val_t align) {
+    return chess::allocate_or_throw(size, static_cast<std::size_t>(align));
+}
+void* operator new[](std::size_t size, std::align_val_t align) {
+    return chess::allocate_or_throw(size, static_cast<std::size_t>(align));
+}
+void* operator new(std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept {
+    return chess::allocate_nothrow(size, static_cast<std::size_t>(align));
+}
+void* operator new[](std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept {
+    return chess::allocate_nothrow(size, static_cast<std::size_t>(align));
+}
+
+void operator delete(void* p) noexcept { chess::deallocate(p); }
+void operator delete[](void* p) noexcept { chess::deallocate(p); }
+void operator delete(void* p, std::size_t) noexcept { chess::deallocate(p); }
+void operator delete[](void* p, std::size_t) noexcept { chess::deallocate(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { chess::deallocate(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { chess::deallocate(p); }
+void operator delete(void* p, std::align_val_t) noexcept { chess::deallocate(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { chess::deallocate(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { chess::deallocate(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { chess::deallocate(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { chess::deallocate(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { chess::deallocate(p); }
+
+#endif
@@ -1,112 +1,107 @@
 #include "chess/attack.h"
 
+#include "chess/magic.h"
+#include "chess/stats.h"
+
 namespace chess {
 
-// Helper: check bounds and compare piece
-static inline bool has_piece(const Position& pos, int sq, Piece p) {
-    return is_valid_square(sq) && pos.at(sq) == p;
+// ------------------------------------------------------------
+// Table construction, evaluated at compile time: the tables are plain
+// constant data, with nothing to initialize at startup.
+// ------------------------------------------------------------
+
+namespace {
+
+constexpr int KNIGHT_DF[8] = {  1,  2,  2,  1, -1, -2, -2, -1 };
+constexpr int KNIGHT_DR[8] = {  2,  1, -1, -2, -2, -1,  1,  2 };
+constexpr int KING_DF[8]   = { -1,  0,  1, -1,  1, -1,  0,  1 };
+constexpr int KING_DR[8]   = { -1, -1, -1,  0,  0,  1,  1,  1 };
+constexpr int PAWN_DF[2]   = { -1,  1 };
+constexpr int WHITE_PAWN_DR[2] = {  1,  1 };
+constexpr int BLACK_PAWN_DR[2] = { -1, -1 };
+
+// For every square, the squares reached by each (df, dr) step that stays on the board.
+template <std::size_t N>
+constexpr SquareTable step_table(const int (&df)[N], const int (&dr)[N]) {
+    SquareTable t{};
+    for (int sq = 0; sq < 64; ++sq) {
+        for (std::size_t i = 0; i < N; ++i) {
+            int f = file_of(sq) + df[i];
+            int r = rank_of(sq) + dr[i];
+            if (f >= 0 && f < 8 && r >= 0 && r < 8) t[sq] |= square_bb(make_square(f, r));
+        }
+    }
+    return t;
 }
 
-// Helper: ray scan in a direction (df, dr) for rook/bishop/queen style attacks
-static bool ray_attacked_by(const Position& pos, int target_sq, Color by, int df, int dr) {
-    int tf = file_of(target_sq);
-    int tr = rank_of(target_sq);
-
-    int f = tf + df;
-    int r = tr + dr;
-
-    while (f >= 0 && f < 8 && r >= 0 && r < 8) {
-        int sq = make_square(f, r);
-        Piece pc = pos.at(sq);
-
-        if (pc != EMPTY) {
-            if (piece_color(pc) != by) return false; // blocked by enemy piece
-
-            PieceType pt = piece_type(pc);
-            // Orthogonal rays: rook or queen
-            if ((df == 0 || dr == 0) && (pt == PT_ROOK || pt == PT_QUEEN)) return true;
-            // Diagonal rays: bishop or queen
-            if ((df != 0 && dr != 0) && (pt == PT_BISHOP || pt == PT_QUEEN)) return true;
-
-            return false; // blocked by friendly piece that isn't an attacker type
+// between (line == false) or line (line == true) for every aligned pair.
+constexpr std::array<SquareTable, 64> ray_table(bool line) {
+    std::array<SquareTable, 64> t{};
+    for (int a = 0; a < 64; ++a) {
+        for (bool rook : { true, false }) {
+            const Bitboard empty_rays = sliding_attacks_slow(a, 0, rook);
+            for (int b = 0; b < 64; ++b) {
+                if (!test_bit(empty_rays, b)) continue;
+                t[a][b] = line ? (empty_rays & sliding_attacks_slow(b, 0, rook)) | square_bb(a) | square_bb(b)
+                               : sliding_attacks_slow(a, square_bb(b), rook) & sliding_attacks_slow(b, square_bb(a), rook);
+            }
         }
-
-        f += df;
-        r += dr;
     }
+    return t;
+}
 
-    return false;
+} // namespace
+
+constexpr SquareTable knight_attack_table = step_table(KNIGHT_DF, KNIGHT_DR);
+constexpr SquareTable king_attack_table = step_table(KING_DF, KING_DR);
+constexpr std::array<SquareTable, 2> pawn_attack_table = {
+    step_table(PAWN_DF, WHITE_PAWN_DR),
+    step_table(PAWN_DF, BLACK_PAWN_DR),
+};
+constexpr std::array<SquareTable, 64> between_table = ray_table(false);
+constexpr std::array<SquareTable, 64> line_table = ray_table(true);
+
+static_assert(knight_attack_table[0] == (square_bb(10) | square_bb(17)));     // a1: c2, b3
+static_assert(pawn_attack_table[BLACK][36] == (square_bb(27) | square_bb(29))); // e5: d4, f4
+static_assert(between_table[0][63] == (0x8040201008040201ull & ~square_bb(0) & ~square_bb(63)));
+static_assert(line_table[8][15] == rank_bb(1) && line_table[0][10] == 0);
+
+Bitboard attackers_to(const Position& pos, int square, Bitboard occupied) {
+    const Bitboard queens = pos.by_type(PT_QUEEN);
+    return (pawn_attacks(BLACK, square) & pos.pieces(WHITE, PT_PAWN))
+         | (pawn_attacks(WHITE, square) & pos.pieces(BLACK, PT_PAWN))
+         | (knight_attacks(square) & pos.by_type(PT_KNIGHT))
+         | (king_attacks(square) & pos.by_type(PT_KING))
+         | (rook_attacks(square, occupied) & (pos.by_type(PT_ROOK) | queens))
+         | (bishop_attacks(square, occupied) & (pos.by_type(PT_BISHOP) | queens));
 }
 
 bool is_square_attacked(const Position& pos, int square, Color by) {
+    CHESS_STAT(STAT_IS_SQUARE_ATTACKED);
     if (!is_valid_square(square)) return false;
 
-    const int f = file_of(square);
-    const int r = rank_of(square);
-
-    // ------------------------------------------------------------
-    // Pawn attacks
-    // White pawns attack (f-1,r-1) and (f+1,r-1) relative to target
-    // Black pawns attack (f-1,r+1) and (f+1,r+1) relative to target
-    // ------------------------------------------------------------
-    if (by == WHITE) {
-        if (r > 0) {
-            if (f > 0 && has_piece(pos, make_square(f - 1, r - 1), WP)) return true;
-            if (f < 7 && has_piece(pos, make_square(f + 1, r - 1), WP)) return true;
-        }
-    } else { // by == BLACK
-        if (r < 7) {
-            if (f > 0 && has_piece(pos, make_square(f - 1, r + 1), BP)) return true;
-            if (f < 7 && has_piece(pos, make_square(f + 1, r + 1), BP)) return true;
-        }
-    }
-
-    // ------------------------------------------------------------
-    // Knight attacks
-    // ------------------------------------------------------------
-    static constexpr int kdf[8] = {  1,  2,  2,  1, -1, -2, -2, -1 };
-    static constexpr int kdr[8] = {  2,  1, -1, -2, -2, -1,  1,  2 };
-
-    const Piece knight = (by == WHITE) ? WN : BN;
-    for (int i = 0; i < 8; ++i) {
-        int nf = f + kdf[i];
-        int nr = r + kdr[i];
-        if (nf >= 0 && nf < 8 && nr >= 0 && nr < 8) {
-            if (has_piece(pos, make_square(nf, nr), knight)) return true;
-        }
-    }
-
     // ------------------------------------------------------------
-    // King attacks (adjacent squares)
+    // Leapers: a piece of `by` attacks the square iff it stands where
+    // the same piece placed on the square would attack (for pawns: a
+    // pawn of the other colour).
     // ------------------------------------------------------------
-    const Piece king = (by == WHITE) ? WK : BK;
-    for (int df = -1; df <= 1; ++df) {
-        for (int dr = -1; dr <= 1; ++dr) {
-            if (df == 0 && dr == 0) continue;
-            int nf = f + df;
-            int nr = r + dr;
-            if (nf >= 0 && nf < 8 && nr >= 0 && nr < 8) {
-                if (has_piece(pos, make_square(nf, nr), king)) return true;
-            }
-        }
-    }
+    if (pawn_attacks(opposite(by), square) & pos.pieces(by, PT_PAWN)) return true;
+    if (knight_attacks(square) & pos.pieces(by, PT_KNIGHT)) return true;
+    if (king_attacks(square) & pos.pieces(by, PT_KING)) return true;
 
     // ------------------------------------------------------------
     // Sliding attacks: bishops/rooks/queens
-    // Use rays in 8 directions
+    // Magic-bitboard lookups from the target square: a slider of `by`
+    // attacks the square iff it sits on the square's own attack set.
     // ------------------------------------------------------------
+    const Bitboard occ = pos.occupied();
+    const Bitboard queens = pos.pieces(by, PT_QUEEN);
+
+    const Bitboard rooks = pos.pieces(by, PT_ROOK) | queens;
+    if (rooks && (rook_attacks(square, occ) & rooks)) return true;
 
-    // Rook/queen directions
-    if (ray_attacked_by(pos, square, by,  1,  0)) return true;
-    if (ray_attacked_by(pos, square, by, -1,  0)) return true;
-    if (ray_attacked_by(pos, square, by,  0,  1)) return true;
-    if (ray_attacked_by(pos, square, by,  0, -1)) return true;
-
-    // Bishop/queen directions
-    if (ray_attacked_by(pos, square, by,  1,  1)) return true;
-    if (ray_attacked_by(pos, square, by,  1, -1)) return true;
-    if (ray_attacked_by(pos, square, by, -1,  1)) return true;
-    if (ray_attacked_by(pos, square, by, -1, -1)) return true;
+    const Bitboard bishops = pos.pieces(by, PT_BISHOP) | queens;
+    if (bishops && (bishop_attacks(square, occ) & bishops)) return true;
 
     return false;
 }
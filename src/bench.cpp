@@ -0,0 +1,370 @@
+#include "chess/bench.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <memory>
+#include <ostream>
+#include <sstream>
+
+#include "chess/fen.h"
+#include "chess/magic.h"
+#include "chess/perft.h"
+#include "chess/position.h"
+
+namespace chess {
+
+const std::vector<BenchPosition>& bench_positions() {
+    // The standard perft positions, sized so that each takes a comparable
+    // share of the run.
+    static const std::vector<BenchPosition> positions = {
+        { "startpos", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 5, 4865609 },
+        { "kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 4, 4085603 },
+        { "position3", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 6, 11030083 },
+        { "position4", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 4, 422333 },
+        { "position5", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 4, 2103487 },
+        { "position6", "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 4, 3894594 },
+        { "promotions", "n1n5/PPPk4/8/8/8/8/4Kppp/5N1N b - - 0 1", 5, 3605103 },
+    };
+    return positions;
+}
+
+std::uint64_t BenchReport::nodes() const {
+    std::uint64_t n = 0;
+    for (const BenchEntry& e : entries) n += e.nodes;
+    return n;
+}
+
+double BenchReport::ms() const {
+    double t = 0.0;
+    for (const BenchEntry& e : entries) t += e.ms;
+    return t;
+}
+
+bool run_bench(int reps, BenchReport& out, bool counters) {
+    std::unique_ptr<PerfCounters> perf;
+    if (counters) perf = std::make_unique<PerfCounters>();
+
+    out = BenchReport{};
+    out.sliders = slider_backend_name(slider_backend());
+    out.reps = std::max(reps, 1);
+
+    bool ok = true;
+    for (const BenchPosition& bp : bench_positions()) {
+        Position pos;
+        if (!from_fen(bp.fen, pos)) {
+            ok = false;
+            continue;
+        }
+
+        BenchEntry e;
+        e.name = bp.name;
+        e.fen = bp.fen;
+        e.depth = bp.depth;
+        e.has_allocs = alloc_stats_enabled;
+        e.ms = std::numeric_limits<double>::max();
+        for (int r = 0; r < out.reps; ++r) {
+            if (perf) perf->start();
+            const AllocScope allocs;
+            const auto t0 = std::chrono::steady_clock::now();
+            e.nodes = perft(pos, bp.depth);
+            const auto t1 = std::chrono::steady_clock::now();
+            e.allocs = allocs.counts();
+            const PerfReading reading = perf ? perf->stop() : PerfReading{};
+
+            const double ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+            if (ms < e.ms) {
+                e.ms = ms;
+                e.counters = reading;
+            }
+        }
+        if (e.nodes != bp.nodes) ok = false;
+        out.entries.push_back(e);
+    }
+    return ok;
+}
+
+// ------------------------------------------------------------
+// JSON
+// ------------------------------------------------------------
+
+static std::string json_string(const std::string& s) {
+    std::string out = "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out + "\"";
+}
+
+static std::string json_number(double v) {
+    char buf[64];
+    std::snprintf(buf, sizeof(buf), "%.3f", v);
+    return buf;
+}
+
+std::string bench_to_json(const BenchReport& report) {
+    std::ostringstream out;
+    out << "{\n"
+        << "  \"version\": 1,\n"
+        << "  \"sliders\": " << json_string(report.sliders) << ",\n"
+        << "  \"reps\": " << report.reps << ",\n"
+        << "  \"total\": { \"nodes\": " << report.nodes() << ", \"ms\": " << json_number(report.ms())
+        << ", \"nps\": " << json_number(report.nps()) << " },\n"
+        << "  \"positions\": [\n";
+    for (std::size_t i = 0; i < report.entries.size(); ++i) {
+        const BenchEntry& e = report.entries[i];
+        out << "    { \"name\": " << json_string(e.name) << ", \"fen\": " << json_string(e.fen)
+            << ", \"depth\": " << e.depth << ", \"nodes\": " << e.nodes << ", \"ms\": " << json_number(e.ms)
+            << ", \"nps\": " << json_number(e.nps());
+        if (e.counters.any()) {
+            out << ", \"counters\": {";
+            const char* sep = " ";
+            for (int k = 0; k < PERF_EVENT_COUNT; ++k) {
+                if (!e.counters.has[k]) continue;
+                out << sep << json_string(perf_event_name(static_cast<PerfEvent>(k))) << ": " << e.counters.value[k];
+                sep = ", ";
+            }
+            out << " }";
+        }
+        if (e.has_allocs) {
+            out << ", \"allocs\": { \"count\": " << e.allocs.allocations << ", \"bytes\": " << e.allocs.bytes
+                << " }";
+        }
+        out << " }" << (i + 1 < report.entries.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+    return out.str();
+}
+
+namespace {
+
+// Just enough JSON to read back what bench_to_json writes (and hand edits of it).
+struct JsonValue {
+    enum Type { Null, Bool, Number, String, Array, Object } type = Null;
+    double number = 0.0;
+    std::string str;
+    std::vector<JsonValue> items;       // Array
+    std::vector<std::string> keys;      // Object, parallel to items
+    const JsonValue* find(const std::string& key) const {
+        for (std::size_t i = 0; i < keys.size(); ++i) {
+            if (keys[i] == key) return &items[i];
+        }
+        return nullptr;
+    }
+};
+
+class JsonParser {
+public:
+    explicit JsonParser(const std::string& text) : s_(text) {}
+
+    bool parse(JsonValue& out) {
+        if (!value(out)) return false;
+        skip_ws();
+        return pos_ == s_.size();
+    }
+
+private:
+    void skip_ws() {
+        while (pos_ < s_.size() && std::isspace(static_cast<unsigned char>(s_[pos_]))) ++pos_;
+    }
+
+    bool consume(char c) {
+        skip_ws();
+        if (pos_ < s_.size() && s_[pos_] == c) {
+            ++pos_;
+            return true;
+        }
+        return false;
+    }
+
+    bool literal(const char* word) {
+        const std::string w(word);
+        if (s_.compare(pos_, w.size(), w) != 0) return false;
+        pos_ += w.size();
+        return true;
+    }
+
+    bool string(std::string& out) {
+        if (!consume('"')) return false;
+        out.clear();
+        while (pos_ < s_.size() && s_[pos_] != '"') {
+            if (s_[pos_] == '\\' && pos_ + 1 < s_.size()) ++pos_;
+            out += s_[pos_++];
+        }
+        return consume('"');
+    }
+
+    bool value(JsonValue& v) {
+        skip_ws();
+        if (pos_ >= s_.size()) return false;
+
+        const char c = s_[pos_];
+        if (c == '{') {
+            v.type = JsonValue::Object;
+            ++pos_;
+            if (consume('}')) return true;
+            do {
+                std::string key;
+                JsonValue item;
+                if (!string(key) || !consume(':') || !value(item)) return false;
+                v.keys.push_back(std::move(key));
+                v.items.push_back(std::move(item));
+            } while (consume(','));
+            return consume('}');
+        }
+        if (c == '[') {
+            v.type = JsonValue::Array;
+            ++pos_;
+            if (consume(']')) return true;
+            do {
+                JsonValue item;
+                if (!value(item)) return false;
+                v.items.push_back(std::move(item));
+            } while (consume(','));
+            return consume(']');
+        }
+        if (c == '"') {
+            v.type = JsonValue::String;
+            return string(v.str);
+        }
+        if (literal("true")) {
+            v.type = JsonValue::Bool;
+            v.number = 1.0;
+            return true;
+        }
+        if (literal("false")) {
+            v.type = JsonValue::Bool;
+            return true;
+        }
+        if (literal("null")) return true;
+
+        const char* begin = s_.c_str() + pos_;
+        char* end = nullptr;
+        v.type = JsonValue::Number;
+        v.number = std::strtod(begin, &end);
+        if (end == begin) return false;
+        pos_ += static_cast<std::size_t>(end - begin);
+        return true;
+    }
+
+    const std::string& s_;
+    std::size_t pos_ = 0;
+};
+
+} // namespace
+
+bool bench_from_json(const std::string& json, BenchReport& out, std::string& error) {
+    JsonValue root;
+    if (!JsonParser(json).parse(root) || root.type != JsonValue::Object) {
+        error = "not a JSON object";
+        return false;
+    }
+
+    const JsonValue* positions = root.find("positions");
+    if (!positions || positions->type != JsonValue::Array) {
+        error = "missing \"positions\" array";
+        return false;
+    }
+
+    out = BenchReport{};
+    if (const JsonValue* v = root.find("sliders")) out.sliders = v->str;
+    if (const JsonValue* v = root.find("reps")) out.reps = static_cast<int>(v->number);
+
+    for (const JsonValue& p : positions->items) {
+        const JsonValue* name = p.find("name");
+        const JsonValue* nodes = p.find("nodes");
+        const JsonValue* ms = p.find("ms");
+        if (!name || !nodes || !ms) {
+            error = "position without name, nodes or ms";
+            return false;
+        }
+
+        BenchEntry e;
+        e.name = name->str;
+        if (const JsonValue* v = p.find("fen")) e.fen = v->str;
+        if (const JsonValue* v = p.find("depth")) e.depth = static_cast<int>(v->number);
+        e.nodes = static_cast<std::uint64_t>(nodes->number);
+        e.ms = ms->number;
+        if (const JsonValue* c = p.find("counters")) {
+            for (int k = 0; k < PERF_EVENT_COUNT; ++k) {
+                const JsonValue* v = c->find(perf_event_name(static_cast<PerfEvent>(k)));
+                if (!v) continue;
+                e.counters.value[k] = static_cast<std::uint64_t>(v->number);
+                e.counters.has[k] = true;
+            }
+        }
+        if (const JsonValue* a = p.find("allocs")) {
+            if (const JsonValue* v = a->find("count")) e.allocs.allocations = static_cast<std::uint64_t>(v->number);
+            if (const JsonValue* v = a->find("bytes")) e.allocs.bytes = static_cast<std::uint64_t>(v->number);
+            e.has_allocs = true;
+        }
+        out.entries.push_back(e);
+    }
+    return true;
+}
+
+// ------------------------------------------------------------
+// Regression check
+// ------------------------------------------------------------
+
+static double change_pct(double now, double before) {
+    return before > 0.0 ? 100.0 * (now - before) / before : 0.0;
+}
+
+bool report_bench_regression(std::ostream& out, const BenchReport& current,
+                             const BenchReport& baseline, double threshold_pct) {
+    char line[160];
+
+    // Totals only over positions present in both, so adding a bench
+    // position doesn't read as a speedup or a slowdown.
+    std::uint64_t now_nodes = 0, base_nodes = 0;
+    double now_ms = 0.0, base_ms = 0.0;
+    bool more_allocs = false;
+
+    for (const BenchEntry& e : current.entries) {
+        const auto it = std::find_if(baseline.entries.begin(), baseline.entries.end(),
+                                     [&](const BenchEntry& b) { return b.name == e.name; });
+        if (it == baseline.entries.end()) {
+            std::snprintf(line, sizeof(line), "%-12s %8.2f Mnps (not in baseline)\n", e.name.c_str(), e.nps() / 1e6);
+            out << line;
+            continue;
+        }
+
+        now_nodes += e.nodes;
+        now_ms += e.ms;
+        base_nodes += it->nodes;
+        base_ms += it->ms;
+        std::snprintf(line, sizeof(line), "%-12s %8.2f -> %8.2f Mnps  %+6.1f%%\n", e.name.c_str(),
+                      it->nps() / 1e6, e.nps() / 1e6, change_pct(e.nps(), it->nps()));
+        out << line;
+
+        // Allocation counts are exact, so any increase is a regression.
+        if (e.has_allocs && it->has_allocs && e.allocs.allocations > it->allocs.allocations) {
+            std::snprintf(line, sizeof(line), "%-12s allocations %llu -> %llu  REGRESSION\n", e.name.c_str(),
+                          static_cast<unsigned long long>(it->allocs.allocations),
+                          static_cast<unsigned long long>(e.allocs.allocations));
+            out << line;
+            more_allocs = true;
+        }
+    }
+
+    const double now_nps = now_ms > 0.0 ? static_cast<double>(now_nodes) * 1000.0 / now_ms : 0.0;
+    const double base_nps = base_ms > 0.0 ? static_cast<double>(base_nodes) * 1000.0 / base_ms : 0.0;
+    const double change = change_pct(now_nps, base_nps);
+    const bool regressed = change < -threshold_pct;
+
+    std::snprintf(line, sizeof(line), "%-12s %8.2f -> %8.2f Mnps  %+6.1f%%  %s (threshold -%.1f%%)\n", "total",
+                  base_nps / 1e6, now_nps / 1e6, change, regressed ? "REGRESSION" : "ok", threshold_pct);
+    out << line;
+    if (!baseline.sliders.empty() && baseline.sliders != current.sliders) {
+        out << "note: baseline used the " << baseline.sliders << " slider backend, this run " << current.sliders
+            << "\n";
+    }
+    return regressed || more_allocs;
+}
+
+} // namespace chess
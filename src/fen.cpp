@@ -67,9 +67,7 @@ bool from_fen(std::string_view fen, Position& out) {
     const std::string& halfmove  = fields[4];
     const std::string& fullmove  = fields[5];
 
-    Position p; // build into temp; only assign to out on success
-    // clear board
-    for (int sq = 0; sq < 64; ++sq) p.set_piece(sq, EMPTY);
+    Position p; // empty board; build into temp and only assign to out on success
 
     // --- piece placement ---
     int rank = 7;
@@ -141,13 +139,7 @@ bool from_fen(std::string_view fen, Position& out) {
 
     // Basic sanity: make sure kings exist (optional but helps)
     // If you prefer to allow illegal FENs for testing, remove this.
-    bool hasWK = false, hasBK = false;
-    for (int sq = 0; sq < 64; ++sq) {
-        Piece pc = p.at(sq);
-        if (pc == WK) hasWK = true;
-        if (pc == BK) hasBK = true;
-    }
-    if (!hasWK || !hasBK) return false;
+    if (!p.pieces(WHITE, PT_KING) || !p.pieces(BLACK, PT_KING)) return false;
 
     out = p;
     return true;
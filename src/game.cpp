@@ -1,12 +1,10 @@
 #include "chess/game.h"
 
-#include <algorithm>
-
 #include "chess/fen.h"
 #include "chess/makemove.h"
 #include "chess/move.h"
 #include "chess/movegen.h"
-#include "chess/zobrist.h"
+#include "chess/trace.h"
 
 namespace chess {
 
@@ -20,7 +18,7 @@ void Game::reset_startpos() {
     undos_.clear();
 
     keys_.clear();
-    keys_.push_back(zobrist_key(pos_));
+    keys_.push_back(pos_.key());
 }
 
 bool Game::set_fen(std::string_view fen_str) {
@@ -32,7 +30,7 @@ bool Game::set_fen(std::string_view fen_str) {
     undos_.clear();
 
     keys_.clear();
-    keys_.push_back(zobrist_key(pos_));
+    keys_.push_back(pos_.key());
     return true;
 }
 
@@ -41,36 +39,23 @@ std::string Game::fen() const {
 }
 
 std::vector<Move> Game::legal_moves() const {
-    // generate_legal requires non-const because it makes/undos internally
-    Position copy = pos_;
     std::vector<Move> out;
-    generate_legal(copy, out);
+    generate_legal(pos_, out);
     return out;
 }
 
-bool Game::same_move(const Move& a, const Move& b) {
-    // Compare by from/to/promo. Flags are position-derived.
-    return a.from == b.from && a.to == b.to && a.promo == b.promo;
-}
-
 bool Game::play_move(const Move& m) {
-    // Validate against generated legal moves
-    Position copy = pos_;
-    std::vector<Move> legals;
-    generate_legal(copy, legals);
-
-    auto it = std::find_if(legals.begin(), legals.end(),
-                           [&](const Move& lm) { return same_move(lm, m); });
-
-    if (it == legals.end()) return false;
+    // Validate from/to/promo directly; flags are position-derived.
+    const std::optional<Move> legal = resolve_move(pos_, m);
+    if (!legal) return false;
 
-    // Use the engine-produced move (correct flags)
+    // Use the resolved move (correct flags)
     Undo u;
-    make_move(pos_, *it, u);
+    make_move(pos_, *legal, u);
 
-    moves_.push_back(*it);
+    moves_.push_back(PackedMove(*legal));
     undos_.push_back(u);
-    keys_.push_back(zobrist_key(pos_));
+    keys_.push_back(pos_.key());
     return true;
 }
 
@@ -93,7 +78,7 @@ bool Game::undo() {
 
     // keys_ has one entry per position, including current
     if (!keys_.empty()) keys_.pop_back();
-    if (keys_.empty()) keys_.push_back(zobrist_key(pos_)); // safety
+    if (keys_.empty()) keys_.push_back(pos_.key()); // safety
 
     return true;
 }
@@ -120,8 +105,10 @@ bool Game::step_ai() {
     if (players_[idx] != PlayerType::AI) return false;
     if (!ai_[idx]) return false;
 
+    TraceScope scope("ai move");
     auto m = ai_[idx](pos_);
     if (!m) return false;
+    if (trace_enabled()) scope.set_detail(move_to_uci(*m));
 
     return play_move(*m);
 }
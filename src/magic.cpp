@@ -0,0 +1,184 @@
+#include "chess/magic.h"
+
+#include <array>
+#include <cstdint>
+
+#if CHESS_PEXT_AVAILABLE
+    #if defined(_MSC_VER)
+        #include <intrin.h>
+    #else
+        #include <cpuid.h>
+    #endif
+#endif
+
+namespace chess {
+
+Magic rook_magics[64];
+Magic bishop_magics[64];
+
+namespace detail {
+bool slider_use_pext = false;
+}
+
+// Shared attack storage: sum over squares of 2^popcount(mask).
+static Bitboard rook_table[0x19000];   // 102400
+static Bitboard bishop_table[0x1480];  // 5248
+
+// xorshift64* (deterministic with fixed seed)
+static std::uint64_t next_random(std::uint64_t& s) {
+    s ^= s >> 12;
+    s ^= s << 25;
+    s ^= s >> 27;
+    return s * 0x2545F4914F6CDD1Dull;
+}
+
+// Magics with few set bits are found much faster.
+static std::uint64_t sparse_random(std::uint64_t& s) {
+    return next_random(s) & next_random(s) & next_random(s);
+}
+
+static void init_slider(Magic* magics, Bitboard* table, bool rook) {
+    std::array<Bitboard, 4096> occupancy{};
+    std::array<Bitboard, 4096> reference{};
+    std::array<int, 4096> epoch{};
+    int attempt = 0;
+
+    std::uint64_t seed = rook ? 0x9E3779B97F4A7C15ull : 0xD1B54A32D192ED03ull;
+    Bitboard* next_slice = table;
+
+    for (int sq = 0; sq < 64; ++sq) {
+        Magic& m = magics[sq];
+
+        // Edge squares never block anything beyond themselves, so they are
+        // not part of the relevant occupancy (unless the slider is on them).
+        const Bitboard edges = ((RANK_1_BB | RANK_8_BB) & ~rank_bb(rank_of(sq))) |
+                               ((FILE_A_BB | FILE_H_BB) & ~file_bb(file_of(sq)));
+
+        m.mask = sliding_attacks_slow(sq, 0, rook) & ~edges;
+        m.shift = static_cast<unsigned>(64 - popcount(m.mask));
+        m.attacks = next_slice;
+
+        // Enumerate every subset of the mask (Carry-Rippler trick).
+        int size = 0;
+        Bitboard b = 0;
+        do {
+            occupancy[size] = b;
+            reference[size] = sliding_attacks_slow(sq, b, rook);
+            ++size;
+            b = (b - m.mask) & m.mask;
+        } while (b);
+
+        // Try candidates until every occupancy maps to a slot that is either
+        // unused in this attempt or already holds the same attack set.
+        for (int i = 0; i < size; ) {
+            m.magic = 0;
+            while (popcount((m.mask * m.magic) >> 56) < 6)
+                m.magic = sparse_random(seed);
+
+            ++attempt;
+            for (i = 0; i < size; ++i) {
+                const unsigned idx = m.index(occupancy[i]);
+                if (epoch[idx] < attempt) {
+                    epoch[idx] = attempt;
+                    m.attacks[idx] = reference[i];
+                } else if (m.attacks[idx] != reference[i]) {
+                    break;
+                }
+            }
+        }
+
+        next_slice += size;
+    }
+}
+
+// Re-lays out each square's slice of the table for the given indexing
+// scheme. Slices keep their size (2^popcount(mask)) under both schemes.
+static void fill_tables(Magic* magics, bool rook, bool use_pext) {
+    for (int sq = 0; sq < 64; ++sq) {
+        const Magic& m = magics[sq];
+        Bitboard b = 0;
+        do {
+            const unsigned idx = use_pext ? static_cast<unsigned>(detail::pext(b, m.mask))
+                                          : m.index(b);
+            m.attacks[idx] = sliding_attacks_slow(sq, b, rook);
+            b = (b - m.mask) & m.mask;
+        } while (b);
+    }
+}
+
+#if CHESS_PEXT_AVAILABLE
+static void cpuid(unsigned leaf, unsigned subleaf, unsigned regs[4]) {
+#if defined(_MSC_VER)
+    int r[4];
+    __cpuidex(r, static_cast<int>(leaf), static_cast<int>(subleaf));
+    for (int i = 0; i < 4; ++i) regs[i] = static_cast<unsigned>(r[i]);
+#else
+    if (!__get_cpuid_count(leaf, subleaf, &regs[0], &regs[1], &regs[2], &regs[3]))
+        regs[0] = regs[1] = regs[2] = regs[3] = 0;
+#endif
+}
+#endif
+
+bool cpu_has_bmi2() {
+#if CHESS_PEXT_AVAILABLE
+    unsigned regs[4];
+    cpuid(0, 0, regs);
+    if (regs[0] < 7) return false;
+    cpuid(7, 0, regs);
+    return (regs[1] >> 8) & 1; // EBX bit 8 = BMI2
+#else
+    return false;
+#endif
+}
+
+// PEXT is microcoded on AMD before Zen 3 (family 19h) and much slower than
+// a magic multiply there, so those CPUs keep the magic backend.
+static bool pext_is_fast() {
+#if CHESS_PEXT_AVAILABLE
+    if (!cpu_has_bmi2()) return false;
+
+    unsigned regs[4];
+    cpuid(0, 0, regs);
+    const bool amd = regs[1] == 0x68747541u   // "Auth"
+                  && regs[3] == 0x69746e65u   // "enti"
+                  && regs[2] == 0x444d4163u;  // "cAMD"
+    if (!amd) return true;
+
+    cpuid(1, 0, regs);
+    unsigned family = (regs[0] >> 8) & 0xF;
+    if (family == 0xF) family += (regs[0] >> 20) & 0xFF;
+    return family >= 0x19;
+#else
+    return false;
+#endif
+}
+
+SliderBackend slider_backend() {
+    return detail::slider_use_pext ? SliderBackend::Pext : SliderBackend::Magic;
+}
+
+const char* slider_backend_name(SliderBackend b) {
+    return b == SliderBackend::Pext ? "pext" : "magic";
+}
+
+bool set_slider_backend(SliderBackend b) {
+    const bool use_pext = (b == SliderBackend::Pext);
+    if (use_pext && !cpu_has_bmi2()) return false;
+    if (use_pext == detail::slider_use_pext) return true;
+
+    fill_tables(rook_magics, true, use_pext);
+    fill_tables(bishop_magics, false, use_pext);
+    detail::slider_use_pext = use_pext;
+    return true;
+}
+
+static const bool magics_initialized = [] {
+    // Magics are always searched so the portable backend stays available.
+    init_slider(rook_magics, rook_table, true);
+    init_slider(bishop_magics, bishop_table, false);
+
+    if (pext_is_fast()) set_slider_backend(SliderBackend::Pext);
+    return true;
+}();
+
+} // namespace chess
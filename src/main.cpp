@@ -1,12 +1,22 @@
+#include <cstdio>
+#include <fstream>
 #include <iostream>
+#include <memory>
+#include <new>
 #include <sstream>
 #include <string>
 #include <vector>
 
+#include "chess/alloc_stats.h"
+#include "chess/bench.h"
 #include "chess/game.h"
 #include "chess/move.h"
+#include "chess/perf_counters.h"
 #include "chess/perft.h"
 #include "chess/rules.h"
+#include "chess/stats.h"
+#include "chess/thread_pool.h"
+#include "chess/trace.h"
 
 static void print_help() {
     std::cout
@@ -21,6 +31,13 @@ static void print_help() {
         << "  undo\n"
         << "  perft <depth>\n"
         << "  divide <depth>\n"
+        << "  hash <mb>\n"
+        << "  hashfile <path> [mb]\n"
+        << "  threads <n>\n"
+        << "  bench [baseline.json [threshold%]]\n"
+        << "  counters on|off\n"
+        << "  stats [reset]\n"
+        << "  trace <file>|off\n"
         << "  draw?\n"
         << "  draw!\n"
         << "  no\n"
@@ -108,6 +125,13 @@ int main() {
     ManualOutcome outcome = ManualOutcome::None;
     DrawOffer offer{};
 
+    // Perft transposition table (disabled until 'hash <mb>' is used).
+    chess::PerftTable perft_table;
+    unsigned perft_threads = 1;
+
+    // Hardware counters around perft/divide ('counters on').
+    std::unique_ptr<chess::PerfCounters> perf_counters;
+
     std::cout << "Chess CLI (type 'help')\n";
     render(game, outcome, offer);
 
@@ -203,8 +227,12 @@ int main() {
                 std::cout << "Usage: perft <depth>\n";
                 continue;
             }
-            chess::Position copy = game.position();
-            std::cout << "perft(" << depth << ") = " << chess::perft(copy, depth) << "\n";
+            const chess::AllocScope allocs;
+            if (perf_counters) perf_counters->start();
+            const uint64_t nodes = chess::perft_parallel(game.position(), depth, perft_threads, &perft_table);
+            std::cout << "perft(" << depth << ") = " << nodes << "\n";
+            if (perf_counters) std::cout << perf_counters->stop().per_node(nodes) << "\n";
+            if (chess::alloc_stats_enabled) std::cout << allocs.counts().per_node(nodes) << "\n";
         }
         else if (cmd == "divide") {
             int depth;
@@ -214,7 +242,140 @@ int main() {
                 continue;
             }
             chess::Position copy = game.position();
-            chess::perft_divide(copy, depth);
+            const chess::AllocScope allocs;
+            if (perf_counters) perf_counters->start();
+            const uint64_t nodes = chess::perft_divide(copy, depth, &perft_table, perft_threads);
+            if (perf_counters) std::cout << perf_counters->stop().per_node(nodes) << "\n";
+            if (chess::alloc_stats_enabled) std::cout << allocs.counts().per_node(nodes) << "\n";
+        }
+        else if (cmd == "hash") {
+            long long mb;
+            iss >> mb;
+            if (!iss || mb < 0) {
+                std::cout << "Usage: hash <mb>   (0 disables the perft hash table)\n";
+                continue;
+            }
+            try {
+                perft_table.resize(static_cast<size_t>(mb));
+            } catch (const std::bad_alloc&) {
+                std::cout << "Could not allocate " << mb << " MB\n";
+            }
+            if (perft_table.enabled())
+                std::cout << "Perft hash table: " << perft_table.size_mb() << " MB\n";
+            else
+                std::cout << "Perft hash table disabled\n";
+        }
+        else if (cmd == "hashfile") {
+            std::string path;
+            long long mb = 256;
+            iss >> path;
+            if (!(iss >> mb)) mb = 256;
+            if (path.empty() || mb < 1) {
+                std::cout << "Usage: hashfile <path> [mb]   (persistent perft hash, default 256 MB when created)\n";
+                continue;
+            }
+            std::string error;
+            if (perft_table.open_file(path, static_cast<size_t>(mb), error))
+                std::cout << "Perft hash file: " << path << " (" << perft_table.size_mb() << " MB)\n";
+            else
+                std::cout << "Could not open perft hash file: " << error << "\n";
+        }
+        else if (cmd == "threads") {
+            int n;
+            iss >> n;
+            if (!iss || n < 1) {
+                std::cout << "Usage: threads <n>   (this machine has "
+                          << chess::hardware_threads() << ")\n";
+                continue;
+            }
+            perft_threads = static_cast<unsigned>(n);
+            std::cout << "Perft threads: " << perft_threads << "\n";
+        }
+        else if (cmd == "counters") {
+            std::string mode;
+            iss >> mode;
+            if (mode == "on") {
+                perf_counters = std::make_unique<chess::PerfCounters>();
+                if (perf_counters->available()) {
+                    std::cout << "Hardware counters on for perft and divide\n";
+                } else {
+                    std::cout << "No hardware counters: " << perf_counters->error() << "\n";
+                    perf_counters.reset();
+                }
+            } else if (mode == "off") {
+                perf_counters.reset();
+                std::cout << "Hardware counters off\n";
+            } else {
+                std::cout << "Usage: counters on|off\n";
+            }
+        }
+        else if (cmd == "trace") {
+            std::string arg;
+            iss >> arg;
+            std::string error;
+            if (arg.empty()) {
+                std::cout << "Usage: trace <file>|off   (Chrome trace-event JSON, also written on quit)\n";
+            } else if (arg == "off") {
+                if (chess::trace_stop(error))
+                    std::cout << "Trace written\n";
+                else
+                    std::cout << "Could not write trace: " << error << "\n";
+            } else if (chess::trace_start(arg, error)) {
+                chess::trace_thread_name("main");
+                std::cout << "Tracing to " << arg << " (perft, divide, AI moves)\n";
+            } else {
+                std::cout << "Could not start trace: " << error << "\n";
+            }
+        }
+        else if (cmd == "stats") {
+            std::string mode;
+            iss >> mode;
+            if (!chess::stats_enabled) {
+                std::cout << "Stats are compiled out (rebuild with `make clean && make STATS=1`)\n";
+            } else if (mode == "reset") {
+                chess::stats_reset();
+                std::cout << "Stats reset\n";
+            } else if (!mode.empty()) {
+                std::cout << "Usage: stats [reset]\n";
+            } else {
+                // Ratios are per make_move, i.e. per interior node visited
+                // (perft counts the last ply without making the moves).
+                const chess::StatCounts counts = chess::stats_snapshot();
+                const uint64_t made = counts[chess::STAT_MAKE_MOVE];
+                char line[112];
+                for (int s = 0; s < chess::STAT_COUNT; ++s) {
+                    std::snprintf(line, sizeof(line), "  %-22s %14llu  %8.3f per make_move\n",
+                                  chess::stat_name(static_cast<chess::Stat>(s)),
+                                  static_cast<unsigned long long>(counts[s]),
+                                  made ? static_cast<double>(counts[s]) / static_cast<double>(made) : 0.0);
+                    std::cout << line;
+                }
+            }
+        }
+        else if (cmd == "bench") {
+            std::string baseline_path;
+            double threshold = 5.0;
+            iss >> baseline_path;
+            if (!baseline_path.empty() && !(iss >> threshold)) threshold = 5.0;
+
+            chess::BenchReport baseline;
+            if (!baseline_path.empty()) {
+                std::ifstream in(baseline_path);
+                std::stringstream text;
+                text << in.rdbuf();
+                std::string error;
+                if (!in || !chess::bench_from_json(text.str(), baseline, error)) {
+                    std::cout << "Could not read baseline " << baseline_path << (error.empty() ? "" : ": ")
+                              << error << "\n";
+                    continue;
+                }
+            }
+
+            chess::BenchReport report;
+            const bool ok = chess::run_bench(3, report);
+            std::cout << chess::bench_to_json(report);
+            if (!ok) std::cout << "Wrong node count: the move generator is broken\n";
+            if (!baseline_path.empty()) chess::report_bench_regression(std::cout, report, baseline, threshold);
         }
         else if (cmd == "draw?") {
             if (is_game_over(game, outcome)) {
@@ -1,5 +1,10 @@
 #include "chess/makemove.h"
 
+#include <cassert>
+
+#include "chess/stats.h"
+#include "chess/zobrist.h"
+
 namespace chess {
 
 // ------------------------------------------------------------
@@ -26,20 +31,27 @@ static void remove_castling_rights_on_rook_capture(Position& pos, int to) {
 
 // ------------------------------------------------------------
 
-bool make_move(Position& pos, const Move& m, Undo& u) {
+// Both halves take the mover's colour as a template parameter, so pawn
+// direction, castling squares and piece codes are compile-time constants.
+
+template <Color Us>
+static void do_make_move(Position& pos, const Move& m, Undo& u) {
+    constexpr Color Them = opposite(Us);
+    constexpr Piece KING = make_piece(Us, PT_KING);
+    constexpr Piece ROOK = make_piece(Us, PT_ROOK);
+    constexpr uint8_t OUR_RIGHTS = (Us == WHITE) ? (CASTLE_WK | CASTLE_WQ) : (CASTLE_BK | CASTLE_BQ);
+    constexpr int up = pawn_push(Us);
 
     u.captured = EMPTY;
     u.castling_rights = pos.castling_rights();
     u.ep_square = pos.ep_square();
     u.halfmove_clock = pos.halfmove_clock();
     u.fullmove_number = pos.fullmove_number();
+    u.key = pos.key();
 
     Piece moving = pos.at(m.from);
     Piece target = pos.at(m.to);
 
-    Color us = pos.side_to_move();
-    Color them = opposite(us);
-
     // --- halfmove clock ---
     if (piece_type(moving) == PT_PAWN || target != EMPTY)
         pos.set_halfmove_clock(0);
@@ -51,7 +63,7 @@ bool make_move(Position& pos, const Move& m, Undo& u) {
 
     // --- capture handling ---
     if (is_en_passant(m)) {
-        int cap_sq = (us == WHITE) ? m.to - 8 : m.to + 8;
+        int cap_sq = m.to - up;
         u.captured = pos.at(cap_sq);
         pos.set_piece(cap_sq, EMPTY);
     } else {
@@ -66,72 +78,47 @@ bool make_move(Position& pos, const Move& m, Undo& u) {
     pos.set_piece(m.from, EMPTY);
 
     // --- king move updates ---
-    if (moving == WK) {
-        pos.set_king_square(WHITE, m.to);
-        pos.set_castling_rights(pos.castling_rights() & ~(CASTLE_WK | CASTLE_WQ));
-    }
-    else if (moving == BK) {
-        pos.set_king_square(BLACK, m.to);
-        pos.set_castling_rights(pos.castling_rights() & ~(CASTLE_BK | CASTLE_BQ));
+    if (moving == KING) {
+        pos.set_king_square(Us, m.to);
+        pos.set_castling_rights(pos.castling_rights() & ~OUR_RIGHTS);
     }
 
     // --- rook move updates ---
-    if (piece_type(moving) == PT_ROOK)
+    if (moving == ROOK)
         remove_castling_rights_on_rook_move(pos, m.from);
 
     // --- pawn double push sets ep square ---
-    if (is_double_push(m)) {
-        int ep = (us == WHITE) ? m.to - 8 : m.to + 8;
-        pos.set_ep_square(ep);
-    }
+    if (is_double_push(m))
+        pos.set_ep_square(m.to - up);
 
     // --- promotion ---
-    if (is_promotion(m)) {
-        PieceType pt = static_cast<PieceType>(m.promo);
-        Piece promoted =
-            (us == WHITE)
-            ? static_cast<Piece>(pt)
-            : static_cast<Piece>(pt + 6); // black pieces are offset by +6
-
-        pos.set_piece(m.to, promoted);
-    }
+    if (is_promotion(m))
+        pos.set_piece(m.to, make_piece(Us, static_cast<PieceType>(m.promo)));
 
-    // --- castling ---
+    // --- castling (rook squares named from White's side) ---
     if (is_castle(m)) {
-        if (m.to == make_square(6,0)) {         // white king side
-            pos.set_piece(make_square(5,0), WR);
-            pos.set_piece(make_square(7,0), EMPTY);
-        }
-        else if (m.to == make_square(2,0)) {    // white queen side
-            pos.set_piece(make_square(3,0), WR);
-            pos.set_piece(make_square(0,0), EMPTY);
-        }
-        else if (m.to == make_square(6,7)) {    // black king side
-            pos.set_piece(make_square(5,7), BR);
-            pos.set_piece(make_square(7,7), EMPTY);
-        }
-        else if (m.to == make_square(2,7)) {    // black queen side
-            pos.set_piece(make_square(3,7), BR);
-            pos.set_piece(make_square(0,7), EMPTY);
+        if (m.to == relative_square(Us, make_square(6,0))) {        // king side
+            pos.set_piece(relative_square(Us, make_square(5,0)), ROOK);
+            pos.set_piece(relative_square(Us, make_square(7,0)), EMPTY);
+        } else {                                                    // queen side
+            pos.set_piece(relative_square(Us, make_square(3,0)), ROOK);
+            pos.set_piece(relative_square(Us, make_square(0,0)), EMPTY);
         }
     }
 
     // --- fullmove increment ---
-    if (us == BLACK)
+    if constexpr (Us == BLACK)
         pos.set_fullmove_number(pos.fullmove_number() + 1);
 
     // --- side to move ---
-    pos.set_side_to_move(them);
-
-    return true;
+    pos.set_side_to_move(Them);
 }
 
-void undo_move(Position& pos, const Move& m, const Undo& u) {
-
-    Color them = pos.side_to_move();
-    Color us = opposite(them);
+template <Color Us>
+static void do_undo_move(Position& pos, const Move& m, const Undo& u) {
+    constexpr Piece ROOK = make_piece(Us, PT_ROOK);
 
-    pos.set_side_to_move(us);
+    pos.set_side_to_move(Us);
 
     pos.set_castling_rights(u.castling_rights);
     pos.set_ep_square(u.ep_square);
@@ -142,43 +129,53 @@ void undo_move(Position& pos, const Move& m, const Undo& u) {
 
     // undo castling rook movement
     if (is_castle(m)) {
-        if (m.to == make_square(6,0)) {
-            pos.set_piece(make_square(7,0), WR);
-            pos.set_piece(make_square(5,0), EMPTY);
-        }
-        else if (m.to == make_square(2,0)) {
-            pos.set_piece(make_square(0,0), WR);
-            pos.set_piece(make_square(3,0), EMPTY);
-        }
-        else if (m.to == make_square(6,7)) {
-            pos.set_piece(make_square(7,7), BR);
-            pos.set_piece(make_square(5,7), EMPTY);
-        }
-        else if (m.to == make_square(2,7)) {
-            pos.set_piece(make_square(0,7), BR);
-            pos.set_piece(make_square(3,7), EMPTY);
+        if (m.to == relative_square(Us, make_square(6,0))) {
+            pos.set_piece(relative_square(Us, make_square(7,0)), ROOK);
+            pos.set_piece(relative_square(Us, make_square(5,0)), EMPTY);
+        } else {
+            pos.set_piece(relative_square(Us, make_square(0,0)), ROOK);
+            pos.set_piece(relative_square(Us, make_square(3,0)), EMPTY);
         }
     }
 
     // undo promotion
-    if (is_promotion(m)) {
-        moving = (us == WHITE) ? WP : BP;
-    }
+    if (is_promotion(m))
+        moving = make_piece(Us, PT_PAWN);
 
     pos.set_piece(m.from, moving);
 
     if (is_en_passant(m)) {
-        int cap_sq = (us == WHITE) ? m.to - 8 : m.to + 8;
-        pos.set_piece(cap_sq, u.captured);
+        pos.set_piece(m.to - pawn_push(Us), u.captured);
         pos.set_piece(m.to, EMPTY);
     } else {
         pos.set_piece(m.to, u.captured);
     }
 
-    if (moving == WK)
-        pos.set_king_square(WHITE, m.from);
-    else if (moving == BK)
-        pos.set_king_square(BLACK, m.from);
+    if (moving == make_piece(Us, PT_KING))
+        pos.set_king_square(Us, m.from);
+
+    pos.set_key(u.key);
+}
+
+bool make_move(Position& pos, const Move& m, Undo& u) {
+    CHESS_STAT(STAT_MAKE_MOVE);
+
+    if (pos.side_to_move() == WHITE) do_make_move<WHITE>(pos, m, u);
+    else do_make_move<BLACK>(pos, m, u);
+
+    // The setters above keep the key up to date; debug builds check it
+    // against a full recompute.
+    assert(pos.key() == zobrist_key(pos));
+
+    return true;
+}
+
+void undo_move(Position& pos, const Move& m, const Undo& u) {
+    CHESS_STAT(STAT_UNDO_MOVE);
+
+    // The side that made the move is the one not to move now.
+    if (pos.side_to_move() == BLACK) do_undo_move<WHITE>(pos, m, u);
+    else do_undo_move<BLACK>(pos, m, u);
 }
 
-} // namespace chess
\ No newline at end of file
+} // namespace chess
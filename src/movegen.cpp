@@ -1,196 +1,135 @@
 #include "chess/movegen.h"
 
 #include "chess/attack.h"
-#include "chess/makemove.h"
-#include "chess/undo.h"
+#include "chess/magic.h"
+#include "chess/stats.h"
 
 namespace chess {
 
-static inline bool is_enemy_piece(Piece p, Color us) {
-    return p != EMPTY && piece_color(p) != us;
-}
+// The generators below take the side to move as a template parameter, so
+// every colour-dependent constant (push direction, start/promotion ranks,
+// castling squares) is fixed at compile time. The public entry points
+// dispatch once on pos.side_to_move().
 
-static inline void add_move(std::vector<Move>& out, int from, int to, uint8_t flags = MF_NONE, uint8_t promo = 0) {
-    out.emplace_back(static_cast<uint8_t>(from), static_cast<uint8_t>(to), flags, promo);
+static inline void add_move(MoveList& out, int from, int to, MoveKind kind = MK_QUIET) {
+    out.emplace_back(from, to, kind);
 }
 
-static void gen_knights(const Position& pos, Color us, std::vector<Move>& out) {
-    static constexpr int kdf[8] = {  1,  2,  2,  1, -1, -2, -2, -1 };
-    static constexpr int kdr[8] = {  2,  1, -1, -2, -2, -1,  1,  2 };
-
-    for (int from = 0; from < 64; ++from) {
-        Piece pc = pos.at(from);
-        if (pc == EMPTY) continue;
-
-        if (piece_type(pc) != PT_KNIGHT || piece_color(pc) != us) continue;
-
-        int f = file_of(from);
-        int r = rank_of(from);
-
-        for (int i = 0; i < 8; ++i) {
-            int nf = f + kdf[i];
-            int nr = r + kdr[i];
-            if (nf < 0 || nf > 7 || nr < 0 || nr > 7) continue;
-
-            int to = make_square(nf, nr);
-            Piece dst = pos.at(to);
-
-            if (dst == EMPTY) add_move(out, from, to);
-            else if (is_enemy_piece(dst, us)) add_move(out, from, to, MF_CAPTURE);
-        }
+static void add_targets(MoveList& out, int from, Bitboard targets, Bitboard enemies) {
+    while (targets) {
+        int to = pop_lsb(targets);
+        add_move(out, from, to, test_bit(enemies, to) ? MK_CAPTURE : MK_QUIET);
     }
 }
 
-static void gen_king_and_castle(const Position& pos, Color us, std::vector<Move>& out) {
-    int from = pos.king_square(us);
-    int f = file_of(from);
-    int r = rank_of(from);
+template <Color Us>
+static void gen_knights(const Position& pos, MoveList& out) {
+    const Bitboard own     = pos.by_color(Us);
+    const Bitboard enemies = pos.by_color(opposite(Us));
 
-    // King steps
-    for (int df = -1; df <= 1; ++df) {
-        for (int dr = -1; dr <= 1; ++dr) {
-            if (df == 0 && dr == 0) continue;
-            int nf = f + df;
-            int nr = r + dr;
-            if (nf < 0 || nf > 7 || nr < 0 || nr > 7) continue;
-
-            int to = make_square(nf, nr);
-            Piece dst = pos.at(to);
-
-            if (dst == EMPTY) add_move(out, from, to);
-            else if (is_enemy_piece(dst, us)) add_move(out, from, to, MF_CAPTURE);
-        }
+    Bitboard knights = pos.pieces(Us, PT_KNIGHT);
+    while (knights) {
+        int from = pop_lsb(knights);
+        add_targets(out, from, knight_attacks(from) & ~own, enemies);
     }
+}
 
-    // Castling (pseudo-legal: also checks empty squares + not currently in check + transit squares not attacked)
-    const Color them = opposite(us);
-
-    if (us == WHITE) {
-        if (pos.castling_rights() & CASTLE_WK) {
-            // e1 -> g1: squares f1, g1 empty; e1,f1,g1 not attacked
-            if (pos.at(make_square(5,0)) == EMPTY && pos.at(make_square(6,0)) == EMPTY) {
-                int e1 = make_square(4,0);
-                int f1 = make_square(5,0);
-                int g1 = make_square(6,0);
-                if (!is_square_attacked(pos, e1, them) &&
-                    !is_square_attacked(pos, f1, them) &&
-                    !is_square_attacked(pos, g1, them)) {
-                    add_move(out, e1, g1, MF_CASTLE);
-                }
+// Castling: rights present, squares between king and rook empty, and the
+// king's start, transit and destination squares not attacked. Returns the
+// king's destination squares (g1 and/or c1, mirrored for Black).
+template <Color Us>
+static Bitboard castling_targets(const Position& pos) {
+    constexpr Color Them = opposite(Us);
+    constexpr uint8_t KING_SIDE  = (Us == WHITE) ? CASTLE_WK : CASTLE_BK;
+    constexpr uint8_t QUEEN_SIDE = (Us == WHITE) ? CASTLE_WQ : CASTLE_BQ;
+
+    // Named from White's side; mirrored onto the 8th rank for Black.
+    constexpr int b1 = relative_square(Us, make_square(1,0));
+    constexpr int c1 = relative_square(Us, make_square(2,0));
+    constexpr int d1 = relative_square(Us, make_square(3,0));
+    constexpr int e1 = relative_square(Us, make_square(4,0));
+    constexpr int f1 = relative_square(Us, make_square(5,0));
+    constexpr int g1 = relative_square(Us, make_square(6,0));
+
+    Bitboard targets = 0;
+    if (pos.castling_rights() & KING_SIDE) {
+        // e1 -> g1: squares f1, g1 empty; e1,f1,g1 not attacked
+        if (pos.at(f1) == EMPTY && pos.at(g1) == EMPTY) {
+            if (!is_square_attacked(pos, e1, Them) &&
+                !is_square_attacked(pos, f1, Them) &&
+                !is_square_attacked(pos, g1, Them)) {
+                targets |= square_bb(g1);
             }
         }
-        if (pos.castling_rights() & CASTLE_WQ) {
-            // e1 -> c1: squares d1,c1,b1 empty; e1,d1,c1 not attacked
-            if (pos.at(make_square(3,0)) == EMPTY && pos.at(make_square(2,0)) == EMPTY && pos.at(make_square(1,0)) == EMPTY) {
-                int e1 = make_square(4,0);
-                int d1 = make_square(3,0);
-                int c1 = make_square(2,0);
-                if (!is_square_attacked(pos, e1, them) &&
-                    !is_square_attacked(pos, d1, them) &&
-                    !is_square_attacked(pos, c1, them)) {
-                    add_move(out, e1, c1, MF_CASTLE);
-                }
-            }
-        }
-    } else {
-        if (pos.castling_rights() & CASTLE_BK) {
-            // e8 -> g8
-            if (pos.at(make_square(5,7)) == EMPTY && pos.at(make_square(6,7)) == EMPTY) {
-                int e8 = make_square(4,7);
-                int f8 = make_square(5,7);
-                int g8 = make_square(6,7);
-                if (!is_square_attacked(pos, e8, them) &&
-                    !is_square_attacked(pos, f8, them) &&
-                    !is_square_attacked(pos, g8, them)) {
-                    add_move(out, e8, g8, MF_CASTLE);
-                }
-            }
-        }
-        if (pos.castling_rights() & CASTLE_BQ) {
-            // e8 -> c8
-            if (pos.at(make_square(3,7)) == EMPTY && pos.at(make_square(2,7)) == EMPTY && pos.at(make_square(1,7)) == EMPTY) {
-                int e8 = make_square(4,7);
-                int d8 = make_square(3,7);
-                int c8 = make_square(2,7);
-                if (!is_square_attacked(pos, e8, them) &&
-                    !is_square_attacked(pos, d8, them) &&
-                    !is_square_attacked(pos, c8, them)) {
-                    add_move(out, e8, c8, MF_CASTLE);
-                }
+    }
+    if (pos.castling_rights() & QUEEN_SIDE) {
+        // e1 -> c1: squares d1,c1,b1 empty; e1,d1,c1 not attacked
+        if (pos.at(d1) == EMPTY && pos.at(c1) == EMPTY && pos.at(b1) == EMPTY) {
+            if (!is_square_attacked(pos, e1, Them) &&
+                !is_square_attacked(pos, d1, Them) &&
+                !is_square_attacked(pos, c1, Them)) {
+                targets |= square_bb(c1);
             }
         }
     }
+    return targets;
 }
 
-static void gen_sliders(const Position& pos, Color us, std::vector<Move>& out) {
-    // Directions: rook (4) + bishop (4)
-    static constexpr int rdf[4] = {  1, -1,  0,  0 };
-    static constexpr int rdr[4] = {  0,  0,  1, -1 };
-    static constexpr int bdf[4] = {  1,  1, -1, -1 };
-    static constexpr int bdr[4] = {  1, -1,  1, -1 };
-
-    for (int from = 0; from < 64; ++from) {
-        Piece pc = pos.at(from);
-        if (pc == EMPTY || piece_color(pc) != us) continue;
-
-        PieceType pt = piece_type(pc);
-        bool rook_like = (pt == PT_ROOK || pt == PT_QUEEN);
-        bool bishop_like = (pt == PT_BISHOP || pt == PT_QUEEN);
-        if (!rook_like && !bishop_like) continue;
-
-        int f0 = file_of(from);
-        int r0 = rank_of(from);
-
-        if (rook_like) {
-            for (int d = 0; d < 4; ++d) {
-                int f = f0 + rdf[d];
-                int r = r0 + rdr[d];
-                while (f >= 0 && f < 8 && r >= 0 && r < 8) {
-                    int to = make_square(f, r);
-                    Piece dst = pos.at(to);
-                    if (dst == EMPTY) {
-                        add_move(out, from, to);
-                    } else {
-                        if (is_enemy_piece(dst, us)) add_move(out, from, to, MF_CAPTURE);
-                        break;
-                    }
-                    f += rdf[d];
-                    r += rdr[d];
-                }
-            }
-        }
+template <Color Us>
+static void gen_castling(const Position& pos, MoveList& out) {
+    constexpr int c1 = relative_square(Us, make_square(2,0));
+    constexpr int e1 = relative_square(Us, make_square(4,0));
+    constexpr int g1 = relative_square(Us, make_square(6,0));
 
-        if (bishop_like) {
-            for (int d = 0; d < 4; ++d) {
-                int f = f0 + bdf[d];
-                int r = r0 + bdr[d];
-                while (f >= 0 && f < 8 && r >= 0 && r < 8) {
-                    int to = make_square(f, r);
-                    Piece dst = pos.at(to);
-                    if (dst == EMPTY) {
-                        add_move(out, from, to);
-                    } else {
-                        if (is_enemy_piece(dst, us)) add_move(out, from, to, MF_CAPTURE);
-                        break;
-                    }
-                    f += bdf[d];
-                    r += bdr[d];
-                }
-            }
-        }
+    const Bitboard targets = castling_targets<Us>(pos);
+    if (test_bit(targets, g1)) add_move(out, e1, g1, MK_KING_CASTLE);
+    if (test_bit(targets, c1)) add_move(out, e1, c1, MK_QUEEN_CASTLE);
+}
+
+template <Color Us>
+static void gen_king_and_castle(const Position& pos, MoveList& out) {
+    const Bitboard own     = pos.by_color(Us);
+    const Bitboard enemies = pos.by_color(opposite(Us));
+
+    // King steps
+    int from = pos.king_square(Us);
+    add_targets(out, from, king_attacks(from) & ~own, enemies);
+
+    gen_castling<Us>(pos, out);
+}
+
+template <Color Us>
+static void gen_sliders(const Position& pos, MoveList& out) {
+    const Bitboard occ     = pos.occupied();
+    const Bitboard own     = pos.by_color(Us);
+    const Bitboard enemies = pos.by_color(opposite(Us));
+
+    const Bitboard rooks   = pos.pieces(Us, PT_ROOK) | pos.pieces(Us, PT_QUEEN);
+    const Bitboard bishops = pos.pieces(Us, PT_BISHOP) | pos.pieces(Us, PT_QUEEN);
+
+    Bitboard sliders = rooks | bishops;
+    while (sliders) {
+        int from = pop_lsb(sliders);
+
+        Bitboard attacks = 0;
+        if (test_bit(rooks, from))   attacks |= rook_attacks(from, occ);
+        if (test_bit(bishops, from)) attacks |= bishop_attacks(from, occ);
+
+        add_targets(out, from, attacks & ~own, enemies);
     }
 }
 
-static void gen_pawns(const Position& pos, Color us, std::vector<Move>& out) {
-    const int dir = (us == WHITE) ? 1 : -1;          // rank direction
-    const int start_rank = (us == WHITE) ? 1 : 6;
-    const int promo_rank = (us == WHITE) ? 6 : 1;    // pawn on this rank can move to last rank and promote
-    const int last_rank  = (us == WHITE) ? 7 : 0;
+template <Color Us>
+static void gen_pawns(const Position& pos, MoveList& out) {
+    constexpr int dir = (Us == WHITE) ? 1 : -1;         // rank direction
+    constexpr int start_rank = relative_rank(Us, 1);
+    constexpr int promo_rank = relative_rank(Us, 6);   // pawn on this rank can move to last rank and promote
 
-    const Piece pawn = (us == WHITE) ? WP : BP;
+    const Bitboard enemies = pos.by_color(opposite(Us));
 
-    for (int from = 0; from < 64; ++from) {
-        if (pos.at(from) != pawn) continue;
+    Bitboard pawns = pos.pieces(Us, PT_PAWN);
+    while (pawns) {
+        int from = pop_lsb(pawns);
 
         int f = file_of(from);
         int r = rank_of(from);
@@ -202,10 +141,10 @@ static void gen_pawns(const Position& pos, Color us, std::vector<Move>& out) {
             if (pos.at(to) == EMPTY) {
                 if (r == promo_rank) {
                     // promotions (quiet)
-                    add_move(out, from, to, MF_PROMOTION, PT_QUEEN);
-                    add_move(out, from, to, MF_PROMOTION, PT_ROOK);
-                    add_move(out, from, to, MF_PROMOTION, PT_BISHOP);
-                    add_move(out, from, to, MF_PROMOTION, PT_KNIGHT);
+                    add_move(out, from, to, MK_PROMO_QUEEN);
+                    add_move(out, from, to, MK_PROMO_ROOK);
+                    add_move(out, from, to, MK_PROMO_BISHOP);
+                    add_move(out, from, to, MK_PROMO_KNIGHT);
                 } else {
                     add_move(out, from, to);
 
@@ -214,7 +153,7 @@ static void gen_pawns(const Position& pos, Color us, std::vector<Move>& out) {
                         int r2 = r + 2 * dir;
                         int to2 = make_square(f, r2);
                         if (pos.at(to2) == EMPTY) {
-                            add_move(out, from, to2, MF_DOUBLE_PUSH);
+                            add_move(out, from, to2, MK_DOUBLE_PUSH);
                         }
                     }
                 }
@@ -222,86 +161,496 @@ static void gen_pawns(const Position& pos, Color us, std::vector<Move>& out) {
         }
 
         // Captures (including promotion captures)
-        for (int df : {-1, 1}) {
-            int nf = f + df;
-            int nr = r + dir;
-            if (nf < 0 || nf > 7 || nr < 0 || nr > 7) continue;
+        const Bitboard attacks = pawn_attacks(Us, from);
+        Bitboard captures = attacks & enemies;
+        while (captures) {
+            int to = pop_lsb(captures);
+            if (r == promo_rank) {
+                add_move(out, from, to, MK_PROMO_QUEEN_CAPTURE);
+                add_move(out, from, to, MK_PROMO_ROOK_CAPTURE);
+                add_move(out, from, to, MK_PROMO_BISHOP_CAPTURE);
+                add_move(out, from, to, MK_PROMO_KNIGHT_CAPTURE);
+            } else {
+                add_move(out, from, to, MK_CAPTURE);
+            }
+        }
+
+        // En passant captures (pseudo-legal): the EP target square must be
+        // one step diagonally forward
+        if (pos.ep_square() != -1 && test_bit(attacks, pos.ep_square())) {
+            add_move(out, from, pos.ep_square(), MK_EN_PASSANT);
+        }
+    }
+}
 
-            int to = make_square(nf, nr);
-            Piece dst = pos.at(to);
+template <Color Us>
+static void gen_pseudo_legal(const Position& pos, MoveList& out) {
+    gen_pawns<Us>(pos, out);
+    gen_knights<Us>(pos, out);
+    gen_sliders<Us>(pos, out);
+    gen_king_and_castle<Us>(pos, out);
+}
 
-            if (dst != EMPTY && is_enemy_piece(dst, us)) {
-                if (r == promo_rank) {
-                    add_move(out, from, to, MF_CAPTURE | MF_PROMOTION, PT_QUEEN);
-                    add_move(out, from, to, MF_CAPTURE | MF_PROMOTION, PT_ROOK);
-                    add_move(out, from, to, MF_CAPTURE | MF_PROMOTION, PT_BISHOP);
-                    add_move(out, from, to, MF_CAPTURE | MF_PROMOTION, PT_KNIGHT);
-                } else {
-                    add_move(out, from, to, MF_CAPTURE);
-                }
+void generate_pseudo_legal(const Position& pos, MoveList& out) {
+    CHESS_STAT(STAT_GENERATE_PSEUDO_LEGAL);
+    out.clear();
+    if (pos.side_to_move() == WHITE) gen_pseudo_legal<WHITE>(pos, out);
+    else gen_pseudo_legal<BLACK>(pos, out);
+}
+
+// ------------------------------------------------------------
+// Legal generation
+//
+// Checkers and pinned pieces are computed once per node; every move is
+// then restricted to squares that keep the king safe, so no make/undo or
+// per-move attack scan is needed:
+//  - king moves: destination not attacked with the king lifted off the board
+//  - double check: king moves only
+//  - single check: other pieces must capture the checker or block its ray
+//  - pinned pieces: stay on the line through the king and the pinner
+//  - en passant: re-test slider attacks on the king with both pawns moved,
+//    which catches the horizontal discovered-check case
+//  - castling: only when not in check (transit squares as in gen_castling)
+// ------------------------------------------------------------
+
+// capture is MK_CAPTURE or MK_QUIET.
+static void add_promotions(MoveList& out, int from, int to, MoveKind capture) {
+    add_move(out, from, to, static_cast<MoveKind>(MK_PROMO_QUEEN | capture));
+    add_move(out, from, to, static_cast<MoveKind>(MK_PROMO_ROOK | capture));
+    add_move(out, from, to, static_cast<MoveKind>(MK_PROMO_BISHOP | capture));
+    add_move(out, from, to, static_cast<MoveKind>(MK_PROMO_KNIGHT | capture));
+}
+
+// Our pieces that are the only blocker between our king and an enemy slider.
+template <Color Us>
+static Bitboard pinned_pieces(const Position& pos, int ksq) {
+    constexpr Color Them = opposite(Us);
+    const Bitboard occ = pos.occupied();
+    const Bitboard queens = pos.pieces(Them, PT_QUEEN);
+
+    Bitboard snipers = (rook_attacks(ksq, 0) & (pos.pieces(Them, PT_ROOK) | queens))
+                     | (bishop_attacks(ksq, 0) & (pos.pieces(Them, PT_BISHOP) | queens));
+
+    Bitboard pinned = 0;
+    while (snipers) {
+        const int s = pop_lsb(snipers);
+        const Bitboard blockers = between_bb(ksq, s) & occ;
+        if (popcount(blockers) == 1) pinned |= blockers & pos.by_color(Us);
+    }
+    return pinned;
+}
+
+template <Color Us>
+static void gen_legal_pawns(const Position& pos, int ksq, Bitboard pinned, Bitboard check_mask, MoveList& out) {
+    constexpr int up = pawn_push(Us);
+    const Bitboard start_rank = rank_bb(relative_rank(Us, 1));
+    const Bitboard promo_rank = rank_bb(relative_rank(Us, 6));
+
+    const Bitboard occ = pos.occupied();
+    const Bitboard enemies = pos.by_color(opposite(Us));
+
+    Bitboard pawns = pos.pieces(Us, PT_PAWN);
+    while (pawns) {
+        const int from = pop_lsb(pawns);
+        const bool promotes = test_bit(promo_rank, from);
+
+        Bitboard allowed = check_mask;
+        if (test_bit(pinned, from)) allowed &= line_bb(ksq, from);
+
+        // Pushes. from_fen accepts a pawn on its last rank, which has
+        // nowhere to go (and no on-board push square to test).
+        const int to = from + up;
+        if (rank_of(from) != relative_rank(Us, 7) && !test_bit(occ, to)) {
+            if (test_bit(allowed, to)) {
+                if (promotes) add_promotions(out, from, to, MK_QUIET);
+                else add_move(out, from, to);
+            }
+
+            const int to2 = to + up;
+            if (test_bit(start_rank, from) && !test_bit(occ, to2) && test_bit(allowed, to2)) {
+                add_move(out, from, to2, MK_DOUBLE_PUSH);
             }
         }
 
-        // En passant captures (pseudo-legal)
-        if (pos.ep_square() != -1) {
-            int ep = pos.ep_square();
-            int ep_f = file_of(ep);
-            int ep_r = rank_of(ep);
+        // Captures
+        Bitboard captures = pawn_attacks(Us, from) & enemies & allowed;
+        while (captures) {
+            const int cap = pop_lsb(captures);
+            if (promotes) add_promotions(out, from, cap, MK_CAPTURE);
+            else add_move(out, from, cap, MK_CAPTURE);
+        }
 
-            // EP target square must be one step diagonally forward
-            if (ep_r == r + dir && (ep_f == f - 1 || ep_f == f + 1)) {
-                add_move(out, from, ep, MF_EN_PASSANT | MF_CAPTURE);
-            }
+        // En passant: two pawns leave the board between king and sliders at
+        // once, so test the resulting occupancy directly instead of masks.
+        const int ep = pos.ep_square();
+        if (ep != -1 && test_bit(pawn_attacks(Us, from), ep)) {
+            const int cap_sq = ep - up;
+            const Bitboard after = (occ ^ square_bb(from) ^ square_bb(cap_sq)) | square_bb(ep);
+            const Bitboard attackers = attackers_to(pos, ksq, after) & enemies & ~square_bb(cap_sq);
+            if (!attackers) add_move(out, from, ep, MK_EN_PASSANT);
+            else CHESS_STAT(STAT_ILLEGAL_REJECTED);
+        }
+    }
+}
+
+template <Color Us>
+static void gen_legal(const Position& pos, MoveList& out) {
+    const int ksq = pos.king_square(Us);
+
+    const Bitboard occ = pos.occupied();
+    const Bitboard own = pos.by_color(Us);
+    const Bitboard enemies = pos.by_color(opposite(Us));
+
+    const Bitboard checkers = attackers_to(pos, ksq, occ) & enemies;
+
+    // King steps, with the king removed so it cannot hide behind itself
+    // on a checking slider's ray.
+    const Bitboard occ_without_king = occ ^ square_bb(ksq);
+    Bitboard king_targets = king_attacks(ksq) & ~own;
+    while (king_targets) {
+        const int to = pop_lsb(king_targets);
+        if (!(attackers_to(pos, to, occ_without_king) & enemies)) {
+            add_move(out, ksq, to, test_bit(enemies, to) ? MK_CAPTURE : MK_QUIET);
+        } else {
+            CHESS_STAT(STAT_ILLEGAL_REJECTED);
         }
+    }
+
+    if (popcount(checkers) > 1) return; // double check: king moves only
 
-        (void)last_rank; // quiet unused var guard (kept for readability)
+    Bitboard check_mask = BB_ALL;
+    if (checkers) check_mask = between_bb(ksq, lsb(checkers)) | checkers;
+    else gen_castling<Us>(pos, out);
+
+    const Bitboard pinned = pinned_pieces<Us>(pos, ksq);
+
+    gen_legal_pawns<Us>(pos, ksq, pinned, check_mask, out);
+
+    // A pinned knight can never stay on the pin line.
+    Bitboard knights = pos.pieces(Us, PT_KNIGHT) & ~pinned;
+    while (knights) {
+        const int from = pop_lsb(knights);
+        add_targets(out, from, knight_attacks(from) & ~own & check_mask, enemies);
+    }
+
+    const Bitboard rooks   = pos.pieces(Us, PT_ROOK) | pos.pieces(Us, PT_QUEEN);
+    const Bitboard bishops = pos.pieces(Us, PT_BISHOP) | pos.pieces(Us, PT_QUEEN);
+
+    Bitboard sliders = rooks | bishops;
+    while (sliders) {
+        const int from = pop_lsb(sliders);
+
+        Bitboard targets = 0;
+        if (test_bit(rooks, from))   targets |= rook_attacks(from, occ);
+        if (test_bit(bishops, from)) targets |= bishop_attacks(from, occ);
+
+        targets &= ~own & check_mask;
+        if (test_bit(pinned, from)) targets &= line_bb(ksq, from);
+
+        add_targets(out, from, targets, enemies);
     }
 }
 
-void generate_pseudo_legal(const Position& pos, std::vector<Move>& out) {
-    out.clear();
-    Color us = pos.side_to_move();
+// ------------------------------------------------------------
+// Legal move counting
+//
+// The same masks as gen_legal, but each piece contributes the popcount of
+// its destination set instead of emitting moves. Unpinned pawns are
+// counted all at once by shifting the pawn set; a promotion counts 4.
+// ------------------------------------------------------------
+
+template <Color Us> constexpr Bitboard shift_up(Bitboard b) { return Us == WHITE ? b << 8 : b >> 8; }
+template <Color Us> constexpr Bitboard shift_up_west(Bitboard b) {
+    b &= ~FILE_A_BB;
+    return Us == WHITE ? b << 7 : b >> 9;
+}
+template <Color Us> constexpr Bitboard shift_up_east(Bitboard b) {
+    b &= ~FILE_H_BB;
+    return Us == WHITE ? b << 9 : b >> 7;
+}
+
+// Pushes and captures (not en passant) of `pawns`, restricted to `allowed`.
+template <Color Us>
+static int count_pawn_moves(Bitboard pawns, Bitboard occ, Bitboard enemies, Bitboard allowed) {
+    const Bitboard third_rank = rank_bb(relative_rank(Us, 2));
+    const Bitboard last_rank  = rank_bb(relative_rank(Us, 7));
+
+    const Bitboard push1 = shift_up<Us>(pawns) & ~occ;
+    const Bitboard push2 = shift_up<Us>(push1 & third_rank) & ~occ & allowed;
+    const Bitboard west  = shift_up_west<Us>(pawns) & enemies & allowed;
+    const Bitboard east  = shift_up_east<Us>(pawns) & enemies & allowed;
 
-    gen_pawns(pos, us, out);
-    gen_knights(pos, us, out);
-    gen_sliders(pos, us, out);
-    gen_king_and_castle(pos, us, out);
+    int count = popcount(push2);
+    for (const Bitboard to : { push1 & allowed, west, east }) {
+        count += popcount(to & ~last_rank) + 4 * popcount(to & last_rank);
+    }
+    return count;
 }
 
-void generate_legal(Position& pos, std::vector<Move>& out) {
-    out.clear();
+template <Color Us>
+static int count_legal(const Position& pos) {
+    constexpr int up = pawn_push(Us);
+    const int ksq = pos.king_square(Us);
 
-    std::vector<Move> pseudo;
-    generate_pseudo_legal(pos, pseudo);
+    const Bitboard occ = pos.occupied();
+    const Bitboard own = pos.by_color(Us);
+    const Bitboard enemies = pos.by_color(opposite(Us));
 
-    Color us = pos.side_to_move();
-    Color them = opposite(us);
+    const Bitboard checkers = attackers_to(pos, ksq, occ) & enemies;
 
-    int king_from = pos.king_square(us);
+    int count = 0;
 
-    for (const Move& m : pseudo) {
-        Undo u;
-        make_move(pos, m, u);
+    const Bitboard occ_without_king = occ ^ square_bb(ksq);
+    Bitboard king_targets = king_attacks(ksq) & ~own;
+    while (king_targets) {
+        const int to = pop_lsb(king_targets);
+        if (!(attackers_to(pos, to, occ_without_king) & enemies)) ++count;
+    }
 
-        // After making the move, it's now opponent's turn.
-        // We need to check if OUR king is attacked in the resulting position.
-        int king_sq = king_from;
+    if (popcount(checkers) > 1) return count;
 
-        // If we moved our king, update to destination (make_move also caches, but we keep it explicit)
-        Piece moved_piece = pos.at(m.to);
-        if (piece_type(moved_piece) == PT_KING && piece_color(moved_piece) == us) {
-            king_sq = m.to;
-        } else {
-            // safer: trust cache
-            king_sq = pos.king_square(us);
+    Bitboard check_mask = BB_ALL;
+    if (checkers) check_mask = between_bb(ksq, lsb(checkers)) | checkers;
+    else count += popcount(castling_targets<Us>(pos));
+
+    const Bitboard pinned = pinned_pieces<Us>(pos, ksq);
+
+    // Pawns: unpinned ones as a set, pinned ones along their pin line.
+    const Bitboard pawns = pos.pieces(Us, PT_PAWN);
+    count += count_pawn_moves<Us>(pawns & ~pinned, occ, enemies, check_mask);
+    Bitboard pinned_pawns = pawns & pinned;
+    while (pinned_pawns) {
+        const int from = pop_lsb(pinned_pawns);
+        count += count_pawn_moves<Us>(square_bb(from), occ, enemies, check_mask & line_bb(ksq, from));
+    }
+
+    // En passant: same occupancy test as gen_legal_pawns.
+    const int ep = pos.ep_square();
+    if (ep != -1) {
+        const int cap_sq = ep - up;
+        Bitboard capturers = pawn_attacks(opposite(Us), ep) & pawns;
+        while (capturers) {
+            const int from = pop_lsb(capturers);
+            const Bitboard after = (occ ^ square_bb(from) ^ square_bb(cap_sq)) | square_bb(ep);
+            if (!(attackers_to(pos, ksq, after) & enemies & ~square_bb(cap_sq))) ++count;
         }
+    }
+
+    Bitboard knights = pos.pieces(Us, PT_KNIGHT) & ~pinned;
+    while (knights) {
+        const int from = pop_lsb(knights);
+        count += popcount(knight_attacks(from) & ~own & check_mask);
+    }
+
+    const Bitboard rooks   = pos.pieces(Us, PT_ROOK) | pos.pieces(Us, PT_QUEEN);
+    const Bitboard bishops = pos.pieces(Us, PT_BISHOP) | pos.pieces(Us, PT_QUEEN);
+
+    Bitboard sliders = rooks | bishops;
+    while (sliders) {
+        const int from = pop_lsb(sliders);
 
-        bool illegal = is_square_attacked(pos, king_sq, them);
+        Bitboard targets = 0;
+        if (test_bit(rooks, from))   targets |= rook_attacks(from, occ);
+        if (test_bit(bishops, from)) targets |= bishop_attacks(from, occ);
 
-        undo_move(pos, m, u);
+        targets &= ~own & check_mask;
+        if (test_bit(pinned, from)) targets &= line_bb(ksq, from);
 
-        if (!illegal) out.push_back(m);
+        count += popcount(targets);
     }
+    return count;
+}
+
+// Stops at the first legal move, trying the candidates that are cheapest to
+// confirm first: king steps (the only ones in double check), then unpinned
+// knights and sliders, whose masked targets are all legal. Castling never
+// needs testing: whenever it is legal, so is the king's step towards the rook.
+template <Color Us>
+static bool has_legal_move(const Position& pos) {
+    constexpr int up = pawn_push(Us);
+    const int ksq = pos.king_square(Us);
+
+    const Bitboard occ = pos.occupied();
+    const Bitboard own = pos.by_color(Us);
+    const Bitboard enemies = pos.by_color(opposite(Us));
+
+    const Bitboard occ_without_king = occ ^ square_bb(ksq);
+    Bitboard king_targets = king_attacks(ksq) & ~own;
+    while (king_targets) {
+        const int to = pop_lsb(king_targets);
+        if (!(attackers_to(pos, to, occ_without_king) & enemies)) return true;
+    }
+
+    const Bitboard checkers = attackers_to(pos, ksq, occ) & enemies;
+    if (popcount(checkers) > 1) return false;
+
+    const Bitboard check_mask = checkers ? between_bb(ksq, lsb(checkers)) | checkers : BB_ALL;
+    const Bitboard pinned = pinned_pieces<Us>(pos, ksq);
+
+    Bitboard knights = pos.pieces(Us, PT_KNIGHT) & ~pinned;
+    while (knights) {
+        if (knight_attacks(pop_lsb(knights)) & ~own & check_mask) return true;
+    }
+
+    const Bitboard rooks   = pos.pieces(Us, PT_ROOK) | pos.pieces(Us, PT_QUEEN);
+    const Bitboard bishops = pos.pieces(Us, PT_BISHOP) | pos.pieces(Us, PT_QUEEN);
+
+    // Unpinned sliders before pinned ones, which have far fewer targets.
+    for (const Bitboard group : { (rooks | bishops) & ~pinned, (rooks | bishops) & pinned }) {
+        Bitboard sliders = group;
+        while (sliders) {
+            const int from = pop_lsb(sliders);
+
+            Bitboard targets = 0;
+            if (test_bit(rooks, from))   targets |= rook_attacks(from, occ);
+            if (test_bit(bishops, from)) targets |= bishop_attacks(from, occ);
+
+            targets &= ~own & check_mask;
+            if (test_bit(pinned, from)) targets &= line_bb(ksq, from);
+            if (targets) return true;
+        }
+    }
+
+    const Bitboard pawns = pos.pieces(Us, PT_PAWN);
+    if (count_pawn_moves<Us>(pawns & ~pinned, occ, enemies, check_mask)) return true;
+    Bitboard pinned_pawns = pawns & pinned;
+    while (pinned_pawns) {
+        const int from = pop_lsb(pinned_pawns);
+        if (count_pawn_moves<Us>(square_bb(from), occ, enemies, check_mask & line_bb(ksq, from))) return true;
+    }
+
+    const int ep = pos.ep_square();
+    if (ep != -1) {
+        const int cap_sq = ep - up;
+        Bitboard capturers = pawn_attacks(opposite(Us), ep) & pawns;
+        while (capturers) {
+            const int from = pop_lsb(capturers);
+            const Bitboard after = (occ ^ square_bb(from) ^ square_bb(cap_sq)) | square_bb(ep);
+            if (!(attackers_to(pos, ksq, after) & enemies & ~square_bb(cap_sq))) return true;
+        }
+    }
+    return false;
+}
+
+// ------------------------------------------------------------
+// Single-move validation
+//
+// Classifies one from/to/promo triple by the moving piece, then applies
+// the same king-safety rules as gen_legal to that move alone.
+// ------------------------------------------------------------
+
+template <Color Us>
+static std::optional<Move> resolve_move(const Position& pos, const Move& m) {
+    constexpr int up = pawn_push(Us);
+    const int from = m.from;
+    const int to = m.to;
+    if (!is_valid_square(from) || !is_valid_square(to)) return std::nullopt;
+
+    const Bitboard occ = pos.occupied();
+    const Bitboard own = pos.by_color(Us);
+    const Bitboard enemies = pos.by_color(opposite(Us));
+    if (!test_bit(own, from) || test_bit(own, to)) return std::nullopt;
+
+    const PieceType pt = piece_type(pos.at(from));
+    const bool promotes = pt == PT_PAWN && rank_of(to) == relative_rank(Us, 7);
+    if (promotes ? (m.promo < PT_KNIGHT || m.promo > PT_QUEEN) : m.promo != PT_NONE) return std::nullopt;
+
+    const int ksq = pos.king_square(Us);
+    const MoveKind capture = test_bit(enemies, to) ? MK_CAPTURE : MK_QUIET;
+
+    if (pt == PT_KING) {
+        if (test_bit(king_attacks(from), to)) {
+            if (attackers_to(pos, to, occ ^ square_bb(from)) & enemies) return std::nullopt;
+            return PackedMove(from, to, capture);
+        }
+        if (!test_bit(castling_targets<Us>(pos), to) || from != relative_square(Us, make_square(4, 0))) {
+            return std::nullopt;
+        }
+        return PackedMove(from, to, to > from ? MK_KING_CASTLE : MK_QUEEN_CASTLE);
+    }
+
+    MoveKind kind = capture;
+    switch (pt) {
+        case PT_PAWN:
+            if (to == from + up && !test_bit(occ, to)) {
+                kind = MK_QUIET;
+            } else if (to == from + 2 * up && rank_of(from) == relative_rank(Us, 1)
+                       && !test_bit(occ, from + up) && !test_bit(occ, to)) {
+                kind = MK_DOUBLE_PUSH;
+            } else if (test_bit(pawn_attacks(Us, from), to) && capture == MK_CAPTURE) {
+                kind = MK_CAPTURE;
+            } else if (test_bit(pawn_attacks(Us, from), to) && to == pos.ep_square()) {
+                // Same occupancy test as gen_legal_pawns.
+                const int cap_sq = to - up;
+                const Bitboard after = (occ ^ square_bb(from) ^ square_bb(cap_sq)) | square_bb(to);
+                if (attackers_to(pos, ksq, after) & enemies & ~square_bb(cap_sq)) return std::nullopt;
+                return PackedMove(from, to, MK_EN_PASSANT);
+            } else {
+                return std::nullopt;
+            }
+            if (promotes) kind = static_cast<MoveKind>(MK_PROMO_KNIGHT | kind | (m.promo - PT_KNIGHT));
+            break;
+        case PT_KNIGHT:
+            if (!test_bit(knight_attacks(from), to)) return std::nullopt;
+            break;
+        case PT_BISHOP:
+            if (!test_bit(bishop_attacks(from, occ), to)) return std::nullopt;
+            break;
+        case PT_ROOK:
+            if (!test_bit(rook_attacks(from, occ), to)) return std::nullopt;
+            break;
+        case PT_QUEEN:
+            if (!test_bit(rook_attacks(from, occ) | bishop_attacks(from, occ), to)) return std::nullopt;
+            break;
+        default:
+            return std::nullopt;
+    }
+
+    // Any other piece must resolve a check and keep to its pin line.
+    const Bitboard checkers = attackers_to(pos, ksq, occ) & enemies;
+    if (checkers) {
+        if (popcount(checkers) > 1) return std::nullopt;
+        if (!test_bit(between_bb(ksq, lsb(checkers)) | checkers, to)) return std::nullopt;
+    }
+    if (test_bit(pinned_pieces<Us>(pos, ksq), from) && !test_bit(line_bb(ksq, from), to)) return std::nullopt;
+
+    return PackedMove(from, to, kind);
+}
+
+void generate_legal(const Position& pos, MoveList& out) {
+    CHESS_STAT(STAT_GENERATE_LEGAL);
+    out.clear();
+    if (pos.side_to_move() == WHITE) gen_legal<WHITE>(pos, out);
+    else gen_legal<BLACK>(pos, out);
+}
+
+int count_legal(const Position& pos) {
+    CHESS_STAT(STAT_COUNT_LEGAL);
+    return pos.side_to_move() == WHITE ? count_legal<WHITE>(pos) : count_legal<BLACK>(pos);
+}
+
+bool has_legal_move(const Position& pos) {
+    return pos.side_to_move() == WHITE ? has_legal_move<WHITE>(pos) : has_legal_move<BLACK>(pos);
+}
+
+std::optional<Move> resolve_move(const Position& pos, const Move& m) {
+    return pos.side_to_move() == WHITE ? resolve_move<WHITE>(pos, m) : resolve_move<BLACK>(pos, m);
+}
+
+bool is_legal(const Position& pos, const Move& m) {
+    return resolve_move(pos, m).has_value();
+}
+
+void generate_pseudo_legal(const Position& pos, std::vector<Move>& out) {
+    MoveList list;
+    generate_pseudo_legal(pos, list);
+    out.assign(list.begin(), list.end());
+}
+
+void generate_legal(const Position& pos, std::vector<Move>& out) {
+    MoveList list;
+    generate_legal(pos, list);
+    out.assign(list.begin(), list.end());
 }
 
-} // namespace chess
\ No newline at end of file
+} // namespace chess
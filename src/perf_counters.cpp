@@ -0,0 +1,167 @@
+#include "chess/perf_counters.h"
+
+#include <cstdio>
+
+#ifdef __linux__
+#include <cerrno>
+#include <cstring>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace chess {
+
+const char* perf_event_name(PerfEvent e) {
+    switch (e) {
+        case PERF_CYCLES: return "cycles";
+        case PERF_INSTRUCTIONS: return "instructions";
+        case PERF_BRANCH_MISSES: return "branch-misses";
+        case PERF_L1D_MISSES: return "L1d-misses";
+        case PERF_LLC_MISSES: return "LLC-misses";
+        case PERF_EVENT_COUNT: break;
+    }
+    return "?";
+}
+
+bool PerfReading::any() const {
+    for (bool h : has) {
+        if (h) return true;
+    }
+    return false;
+}
+
+std::string PerfReading::per_node(std::uint64_t nodes, const char* unit) const {
+    std::string out;
+    char buf[96];
+
+    if (has[PERF_CYCLES] && has[PERF_INSTRUCTIONS] && value[PERF_CYCLES] != 0) {
+        std::snprintf(buf, sizeof(buf), "IPC %.2f",
+                      static_cast<double>(value[PERF_INSTRUCTIONS]) / static_cast<double>(value[PERF_CYCLES]));
+        out += buf;
+    }
+    if (nodes == 0) return out;
+
+    for (int e = 0; e < PERF_EVENT_COUNT; ++e) {
+        if (!has[e]) continue;
+        std::snprintf(buf, sizeof(buf), "%s%s/%s %.3g", out.empty() ? "" : "  ",
+                      perf_event_name(static_cast<PerfEvent>(e)), unit,
+                      static_cast<double>(value[e]) / static_cast<double>(nodes));
+        out += buf;
+    }
+    return out;
+}
+
+#ifdef __linux__
+
+static int open_event(PerfEvent e) {
+    perf_event_attr attr{};
+    attr.size = sizeof(attr);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.inherit = 1; // also count threads started while counting (perft worker pools)
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    switch (e) {
+        case PERF_CYCLES:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CPU_CYCLES;
+            break;
+        case PERF_INSTRUCTIONS:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+            break;
+        case PERF_BRANCH_MISSES:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+            break;
+        case PERF_L1D_MISSES:
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                          (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            break;
+        case PERF_LLC_MISSES:
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CACHE_MISSES;
+            break;
+        case PERF_EVENT_COUNT:
+            return -1;
+    }
+
+    return static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+}
+
+PerfCounters::PerfCounters() {
+    int first_errno = 0;
+    for (int e = 0; e < PERF_EVENT_COUNT; ++e) {
+        fds_[e] = open_event(static_cast<PerfEvent>(e));
+        if (fds_[e] < 0 && first_errno == 0) first_errno = errno;
+    }
+    if (!available()) {
+        error_ = std::string("perf_event_open: ") + std::strerror(first_errno);
+        if (first_errno == EACCES || first_errno == EPERM) error_ += " (see /proc/sys/kernel/perf_event_paranoid)";
+    }
+}
+
+PerfCounters::~PerfCounters() {
+    for (int fd : fds_) {
+        if (fd >= 0) ::close(fd);
+    }
+}
+
+bool PerfCounters::available() const {
+    for (int fd : fds_) {
+        if (fd >= 0) return true;
+    }
+    return false;
+}
+
+void PerfCounters::start() {
+    for (int fd : fds_) {
+        if (fd < 0) continue;
+        ::ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ::ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+}
+
+PerfReading PerfCounters::stop() {
+    for (int fd : fds_) {
+        if (fd >= 0) ::ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+    }
+
+    PerfReading r;
+    for (int e = 0; e < PERF_EVENT_COUNT; ++e) {
+        std::uint64_t buf[3]; // value, time enabled, time running
+        if (fds_[e] < 0 || ::read(fds_[e], buf, sizeof(buf)) != static_cast<ssize_t>(sizeof(buf))) continue;
+        if (buf[2] == 0) continue; // never got a hardware counter
+
+        // Scale up if the kernel had to multiplex the counter.
+        r.value[e] = buf[2] < buf[1]
+            ? static_cast<std::uint64_t>(static_cast<double>(buf[0]) * static_cast<double>(buf[1]) /
+                                         static_cast<double>(buf[2]))
+            : buf[0];
+        r.has[e] = true;
+    }
+    return r;
+}
+
+#else
+
+PerfCounters::PerfCounters() : error_("hardware counters need Linux perf_event_open") {
+    for (int& fd : fds_) fd = -1;
+}
+
+PerfCounters::~PerfCounters() = default;
+
+bool PerfCounters::available() const { return false; }
+
+void PerfCounters::start() {}
+
+PerfReading PerfCounters::stop() { return {}; }
+
+#endif
+
+} // namespace chess
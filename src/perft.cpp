@@ -1,47 +1,189 @@
 #include "chess/perft.h"
 
+#include <algorithm>
 #include <iostream>
-#include <vector>
+#include <string>
 
 #include "chess/movegen.h"
 #include "chess/makemove.h"
 #include "chess/undo.h"
 #include "chess/move.h"
+#include "chess/thread_pool.h"
+#include "chess/trace.h"
 
 namespace chess {
 
-uint64_t perft(Position& pos, int depth) {
+uint64_t perft(Position& pos, int depth, PerftTable* table) {
     if (depth <= 0) return 1;
 
-    std::vector<Move> moves;
-    generate_legal(pos, moves);
-
-    if (depth == 1) {
-        return static_cast<uint64_t>(moves.size());
+    // Depth-1 counts are cheaper to regenerate than to look up.
+    const bool use_table = table && depth >= 2;
+    if (use_table) {
+        uint64_t cached;
+        if (table->probe(pos.key(), depth, cached)) return cached;
     }
 
+    // Leaves are most of the tree: count them without building a list.
+    if (depth == 1) return static_cast<uint64_t>(count_legal(pos));
+
+    MoveList moves;
+    generate_legal(pos, moves);
+
     uint64_t nodes = 0;
-    for (const auto& m : moves) {
+    for (const Move m : moves) {
         Undo u;
         make_move(pos, m, u);
-        nodes += perft(pos, depth - 1);
+        nodes += perft(pos, depth - 1, table);
         undo_move(pos, m, u);
     }
+
+    if (use_table) table->store(pos.key(), depth, nodes);
     return nodes;
 }
 
-uint64_t perft_divide(Position& pos, int depth) {
-    std::vector<Move> moves;
-    generate_legal(pos, moves);
+static void perft_by_depth_rec(Position& pos, int ply, int max_depth, uint64_t* counts) {
+    // Every legal move here is a node at ply + 1.
+    if (ply + 1 == max_depth) {
+        counts[ply] += static_cast<uint64_t>(count_legal(pos));
+        return;
+    }
 
-    uint64_t total = 0;
+    MoveList moves;
+    generate_legal(pos, moves);
+    counts[ply] += moves.size();
 
-    for (const auto& m : moves) {
+    for (const Move m : moves) {
         Undo u;
         make_move(pos, m, u);
-        uint64_t n = perft(pos, depth - 1);
+        perft_by_depth_rec(pos, ply + 1, max_depth, counts);
         undo_move(pos, m, u);
+    }
+}
+
+std::vector<uint64_t> perft_by_depth(Position& pos, int max_depth) {
+    std::vector<uint64_t> counts(static_cast<size_t>(std::max(max_depth, 0)), 0);
+    if (max_depth > 0) perft_by_depth_rec(pos, 0, max_depth, counts.data());
+    return counts;
+}
+
+// ------------------------------------------------------------
+// Parallel perft
+// ------------------------------------------------------------
+
+namespace {
+
+struct PerftJob {
+    Position pos;
+    int depth = 0;        // remaining depth below pos
+    std::size_t root = 0; // index of the root move this subtree belongs to
+    uint64_t nodes = 0;
+};
+
+// Jobs per thread to aim for; enough for work stealing to even out
+// subtrees of very different sizes.
+constexpr std::size_t JOBS_PER_THREAD = 16;
+
+// Don't split below this remaining depth: such subtrees are too small to
+// be worth a task.
+constexpr int MIN_SPLIT_DEPTH = 3;
+
+} // namespace
+
+// One job per root move, then repeatedly replace every job by its children
+// while there are fewer jobs than the pool wants. Children keep their root
+// index so per-move totals can be reassembled.
+static std::vector<PerftJob> split_jobs(const Position& pos, int depth, const MoveList& root_moves,
+                                        std::size_t target) {
+    std::vector<PerftJob> jobs;
+    jobs.reserve(root_moves.size());
+    for (std::size_t i = 0; i < root_moves.size(); ++i) {
+        PerftJob job{pos, depth - 1, i, 0};
+        Undo u;
+        make_move(job.pos, root_moves[i], u);
+        jobs.push_back(job);
+    }
+
+    while (jobs.size() < target) {
+        std::vector<PerftJob> next;
+        bool split_any = false;
+
+        for (const PerftJob& job : jobs) {
+            if (job.depth < MIN_SPLIT_DEPTH) {
+                next.push_back(job);
+                continue;
+            }
+
+            // A node without legal moves simply contributes no children (0 nodes).
+            MoveList moves;
+            generate_legal(job.pos, moves);
+            for (const Move m : moves) {
+                PerftJob child{job.pos, job.depth - 1, job.root, 0};
+                Undo u;
+                make_move(child.pos, m, u);
+                next.push_back(child);
+            }
+            split_any = true;
+        }
+
+        jobs = std::move(next);
+        if (!split_any) break;
+    }
+    return jobs;
+}
+
+std::vector<std::pair<Move, uint64_t>> perft_divide_counts(const Position& pos, int depth,
+                                                           unsigned threads, PerftTable* table) {
+    MoveList moves;
+    generate_legal(pos, moves);
+
+    std::vector<std::pair<Move, uint64_t>> out;
+    out.reserve(moves.size());
+    for (const Move m : moves) out.emplace_back(m, 0);
+
+    if (threads <= 1) {
+        Position copy = pos;
+        for (auto& [m, n] : out) {
+            TraceScope scope("perft root", trace_enabled() ? move_to_uci(m) : std::string());
+            Undo u;
+            make_move(copy, m, u);
+            n = perft(copy, depth - 1, table);
+            undo_move(copy, m, u);
+        }
+        return out;
+    }
+
+    std::vector<PerftJob> jobs = split_jobs(pos, depth, moves, threads * JOBS_PER_THREAD);
+    {
+        ThreadPool pool(threads);
+        for (PerftJob& job : jobs) {
+            pool.submit([&job, &moves, table] {
+                TraceScope scope("perft job", trace_enabled() ? move_to_uci(moves[job.root]) : std::string());
+                job.nodes = perft(job.pos, job.depth, table);
+            });
+        }
+        pool.wait();
+    }
+
+    for (const PerftJob& job : jobs) out[job.root].second += job.nodes;
+    return out;
+}
+
+uint64_t perft_parallel(const Position& pos, int depth, unsigned threads, PerftTable* table) {
+    TraceScope scope("perft", trace_enabled() ? "depth " + std::to_string(depth) : std::string());
+    if (threads <= 1 || depth <= 1) {
+        Position copy = pos;
+        return perft(copy, depth, table);
+    }
+
+    uint64_t total = 0;
+    for (const auto& [m, n] : perft_divide_counts(pos, depth, threads, table)) total += n;
+    return total;
+}
+
+uint64_t perft_divide(Position& pos, int depth, PerftTable* table, unsigned threads) {
+    uint64_t total = 0;
 
+    for (const auto& [m, n] : perft_divide_counts(pos, depth, threads, table)) {
         std::cout << move_to_uci(m) << ": " << n << "\n";
         total += n;
     }
@@ -50,4 +192,4 @@ uint64_t perft_divide(Position& pos, int depth) {
     return total;
 }
 
-} // namespace chess
\ No newline at end of file
+} // namespace chess
@@ -0,0 +1,414 @@
+#include "chess/perft_dist.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <unordered_map>
+
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/prctl.h>
+#endif
+
+#include "chess/fen.h"
+#include "chess/makemove.h"
+#include "chess/move.h"
+#include "chess/movegen.h"
+#include "chess/perft.h"
+#include "chess/perft_table.h"
+#include "chess/undo.h"
+
+namespace chess {
+
+static void collect_subtrees(Position& pos, int plies, int depth, std::string& path,
+                             std::vector<PerftSubtree>& out) {
+    if (plies == 0) {
+        out.push_back({path.empty() ? "-" : path, to_fen(pos), depth});
+        return;
+    }
+
+    // A node without legal moves above the split contributes no subtrees (0 nodes).
+    MoveList moves;
+    generate_legal(pos, moves);
+    for (const Move m : moves) {
+        const std::size_t len = path.size();
+        if (!path.empty()) path += '.';
+        path += move_to_uci(m);
+
+        Undo u;
+        make_move(pos, m, u);
+        collect_subtrees(pos, plies - 1, depth, path, out);
+        undo_move(pos, m, u);
+
+        path.resize(len);
+    }
+}
+
+std::vector<PerftSubtree> split_perft_subtrees(const Position& pos, int depth, int split_depth) {
+    split_depth = std::clamp(split_depth, 0, std::max(depth - 1, 0));
+
+    std::vector<PerftSubtree> out;
+    Position copy = pos;
+    std::string path;
+    collect_subtrees(copy, split_depth, depth - split_depth, path, out);
+    return out;
+}
+
+// ------------------------------------------------------------
+// Line protocol over a socket
+// ------------------------------------------------------------
+//
+// coordinator -> worker:  "<id> <depth> <fen>\n"
+// worker -> coordinator:  "<id> <nodes>\n"
+// The coordinator shuts down its write side when it has no more work;
+// the worker exits on EOF.
+
+namespace {
+
+#ifdef MSG_NOSIGNAL
+constexpr int SEND_FLAGS = MSG_NOSIGNAL; // a dead peer is an error, not SIGPIPE
+#else
+constexpr int SEND_FLAGS = 0;
+#endif
+
+class LineChannel {
+public:
+    explicit LineChannel(int fd) : fd_(fd) {}
+
+    int fd() const { return fd_; }
+
+    // One read from the socket; false on EOF or error.
+    bool fill() {
+        char buf[4096];
+        while (true) {
+            const ssize_t n = ::read(fd_, buf, sizeof(buf));
+            if (n > 0) {
+                buffer_.append(buf, static_cast<std::size_t>(n));
+                return true;
+            }
+            if (n < 0 && errno == EINTR) continue;
+            return false;
+        }
+    }
+
+    // Next complete line among the bytes read so far.
+    bool next_line(std::string& line) {
+        const std::size_t nl = buffer_.find('\n');
+        if (nl == std::string::npos) return false;
+        line.assign(buffer_, 0, nl);
+        buffer_.erase(0, nl + 1);
+        return true;
+    }
+
+    bool send_line(const std::string& line) {
+        const std::string msg = line + '\n';
+        std::size_t sent = 0;
+        while (sent < msg.size()) {
+            const ssize_t n = ::send(fd_, msg.data() + sent, msg.size() - sent, SEND_FLAGS);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            sent += static_cast<std::size_t>(n);
+        }
+        return true;
+    }
+
+private:
+    int fd_;
+    std::string buffer_;
+};
+
+struct Worker {
+    pid_t pid = -1;
+    LineChannel channel{-1};
+    long job = -1; // subtree index in flight, -1 when idle
+};
+
+} // namespace
+
+[[noreturn]] static void worker_main(int fd, std::size_t hash_mb) {
+    PerftTable table(hash_mb);
+    LineChannel channel(fd);
+    std::string line;
+
+    while (true) {
+        if (!channel.next_line(line)) {
+            if (!channel.fill()) _exit(0);
+            continue;
+        }
+
+        std::istringstream in(line);
+        std::size_t id = 0;
+        int depth = 0;
+        std::string fen;
+        in >> id >> depth;
+        std::getline(in >> std::ws, fen);
+
+        Position pos;
+        if (!in || !from_fen(fen, pos)) _exit(2);
+
+        const uint64_t nodes = perft(pos, depth, &table);
+        if (!channel.send_line(std::to_string(id) + " " + std::to_string(nodes))) _exit(3);
+    }
+}
+
+// ------------------------------------------------------------
+// Checkpoint file
+// ------------------------------------------------------------
+//
+// First line identifies the run; every further line is "<path> <nodes>".
+// A final line without its newline is a write cut short and is ignored.
+
+static std::string checkpoint_header(const Position& pos, int depth, int split_depth) {
+    return "perft-checkpoint 1 depth " + std::to_string(depth) + " split " +
+           std::to_string(split_depth) + " fen " + to_fen(pos);
+}
+
+static bool load_checkpoint(const std::string& file, const std::string& header,
+                            const std::unordered_map<std::string, std::size_t>& index,
+                            std::vector<uint64_t>& nodes, std::vector<bool>& done,
+                            std::size_t& resumed, std::string& error) {
+    std::ifstream in(file);
+    if (!in) return true; // nothing to resume
+
+    std::string line;
+    if (!std::getline(in, line) || in.eof()) return true; // header never completed
+    if (line != header) {
+        error = "checkpoint " + file + " belongs to a different run: " + line;
+        return false;
+    }
+
+    while (std::getline(in, line)) {
+        if (in.eof()) break; // truncated last record
+
+        std::istringstream rec(line);
+        std::string path;
+        uint64_t n = 0;
+        if (!(rec >> path >> n)) {
+            error = "bad checkpoint record: " + line;
+            return false;
+        }
+
+        const auto it = index.find(path);
+        if (it == index.end()) {
+            error = "checkpoint has unknown subtree " + path;
+            return false;
+        }
+        if (!done[it->second]) {
+            done[it->second] = true;
+            nodes[it->second] = n;
+            ++resumed;
+        }
+    }
+    return true;
+}
+
+// Writes the header and every finished subtree to a fresh file and moves
+// it over `file`. This drops a truncated last record, which new records
+// would otherwise be appended to.
+static bool rewrite_checkpoint(const std::string& file, const std::string& header,
+                               const std::vector<PerftSubtree>& subtrees,
+                               const std::vector<uint64_t>& nodes, const std::vector<bool>& done) {
+    const std::string tmp = file + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::trunc);
+        out << header << '\n';
+        for (std::size_t i = 0; i < subtrees.size(); ++i) {
+            if (done[i]) out << subtrees[i].path << ' ' << nodes[i] << '\n';
+        }
+        if (!out.flush()) return false;
+    }
+    return std::rename(tmp.c_str(), file.c_str()) == 0;
+}
+
+// ------------------------------------------------------------
+// Coordinator
+// ------------------------------------------------------------
+
+static bool spawn_worker(std::vector<Worker>& workers, std::size_t hash_mb, std::string& error) {
+    int sv[2];
+    if (::socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0) {
+        error = std::string("socketpair: ") + std::strerror(errno);
+        return false;
+    }
+
+    // Don't let buffered output be written twice.
+    std::cout.flush();
+    std::cerr.flush();
+
+    const pid_t pid = ::fork();
+    if (pid < 0) {
+        error = std::string("fork: ") + std::strerror(errno);
+        ::close(sv[0]);
+        ::close(sv[1]);
+        return false;
+    }
+    if (pid == 0) {
+#ifdef __linux__
+        // Don't outlive a coordinator that was killed mid-run.
+        ::prctl(PR_SET_PDEATHSIG, SIGKILL);
+        if (::getppid() == 1) _exit(1);
+#endif
+        ::close(sv[0]);
+        for (const Worker& w : workers) ::close(w.channel.fd());
+        worker_main(sv[1], hash_mb);
+    }
+
+    ::close(sv[1]);
+    Worker w;
+    w.pid = pid;
+    w.channel = LineChannel(sv[0]);
+    workers.push_back(std::move(w));
+    return true;
+}
+
+static void reap_workers(std::vector<Worker>& workers, bool kill) {
+    for (Worker& w : workers) {
+        if (kill) ::kill(w.pid, SIGKILL);
+        ::close(w.channel.fd());
+    }
+    for (Worker& w : workers) {
+        int status = 0;
+        while (::waitpid(w.pid, &status, 0) < 0 && errno == EINTR) {}
+    }
+    workers.clear();
+}
+
+DistributedPerftResult perft_distributed(const Position& pos, int depth,
+                                         const DistributedPerftOptions& opts) {
+    DistributedPerftResult result;
+
+    const int split_depth = std::clamp(opts.split_depth, 0, std::max(depth - 1, 0));
+    const std::vector<PerftSubtree> subtrees = split_perft_subtrees(pos, depth, split_depth);
+    result.subtrees = subtrees.size();
+
+    std::unordered_map<std::string, std::size_t> index;
+    for (std::size_t i = 0; i < subtrees.size(); ++i) index.emplace(subtrees[i].path, i);
+
+    std::vector<uint64_t> nodes(subtrees.size(), 0);
+    std::vector<bool> done(subtrees.size(), false);
+
+    const std::string header = checkpoint_header(pos, depth, split_depth);
+    if (!opts.checkpoint.empty() &&
+        !load_checkpoint(opts.checkpoint, header, index, nodes, done, result.resumed, result.error)) {
+        return result;
+    }
+
+    std::vector<std::size_t> todo;
+    for (std::size_t i = 0; i < subtrees.size(); ++i) {
+        if (!done[i]) todo.push_back(i);
+    }
+
+    // Workers are forked before the checkpoint is opened so they don't inherit it.
+    std::vector<Worker> workers;
+    const std::size_t worker_count = std::min<std::size_t>(std::max(opts.workers, 1u), todo.size());
+    for (std::size_t i = 0; i < worker_count; ++i) {
+        if (!spawn_worker(workers, opts.hash_mb, result.error)) {
+            reap_workers(workers, true);
+            return result;
+        }
+    }
+
+    std::ofstream checkpoint;
+    if (!opts.checkpoint.empty()) {
+        if (!rewrite_checkpoint(opts.checkpoint, header, subtrees, nodes, done)) {
+            result.error = "cannot write checkpoint " + opts.checkpoint;
+            reap_workers(workers, true);
+            return result;
+        }
+        checkpoint.open(opts.checkpoint, std::ios::app);
+    }
+
+    std::size_t next = 0;
+    auto dispatch = [&](Worker& w) {
+        if (next == todo.size()) {
+            w.job = -1;
+            ::shutdown(w.channel.fd(), SHUT_WR); // no more work: worker exits on EOF
+            return;
+        }
+        const std::size_t id = todo[next++];
+        w.job = static_cast<long>(id);
+        // A failed send shows up as EOF on the next read.
+        w.channel.send_line(std::to_string(id) + " " + std::to_string(subtrees[id].depth) + " " +
+                            subtrees[id].fen);
+    };
+    for (Worker& w : workers) dispatch(w);
+
+    std::size_t finished = 0;
+    std::vector<pollfd> fds;
+    std::vector<Worker*> polled;
+    std::string line;
+
+    while (finished < todo.size()) {
+        fds.clear();
+        polled.clear();
+        for (Worker& w : workers) {
+            if (w.job < 0) continue;
+            fds.push_back({w.channel.fd(), POLLIN, 0});
+            polled.push_back(&w);
+        }
+
+        if (::poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno == EINTR) continue;
+            result.error = std::string("poll: ") + std::strerror(errno);
+            reap_workers(workers, true);
+            return result;
+        }
+
+        for (std::size_t k = 0; k < fds.size(); ++k) {
+            if (fds[k].revents == 0) continue;
+            Worker& w = *polled[k];
+
+            if (!w.channel.fill()) {
+                result.error = "worker " + std::to_string(w.pid) + " exited while searching " +
+                               subtrees[static_cast<std::size_t>(w.job)].path;
+                reap_workers(workers, true);
+                return result;
+            }
+
+            while (w.job >= 0 && w.channel.next_line(line)) {
+                std::istringstream rec(line);
+                std::size_t id = 0;
+                uint64_t n = 0;
+                if (!(rec >> id >> n) || static_cast<long>(id) != w.job) {
+                    result.error = "unexpected reply from worker: " + line;
+                    reap_workers(workers, true);
+                    return result;
+                }
+
+                nodes[id] = n;
+                done[id] = true;
+                ++finished;
+                if (checkpoint.is_open()) checkpoint << subtrees[id].path << ' ' << n << '\n' << std::flush;
+                if (opts.progress) {
+                    std::cerr << "[" << (result.resumed + finished) << "/" << subtrees.size() << "] "
+                              << subtrees[id].path << ": " << n << "\n";
+                }
+                dispatch(w);
+            }
+        }
+    }
+    reap_workers(workers, false);
+
+    // Totals per root move, in generate_legal order.
+    for (std::size_t i = 0; i < subtrees.size(); ++i) {
+        result.nodes += nodes[i];
+        if (split_depth == 0) continue;
+
+        const std::string root = subtrees[i].path.substr(0, subtrees[i].path.find('.'));
+        if (result.divide.empty() || result.divide.back().first != root) result.divide.emplace_back(root, 0);
+        result.divide.back().second += nodes[i];
+    }
+
+    result.ok = true;
+    return result;
+}
+
+} // namespace chess
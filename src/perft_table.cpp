@@ -0,0 +1,271 @@
+#include "chess/perft_table.h"
+
+#include <cerrno>
+#include <cstring>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "chess/zobrist.h"
+
+namespace chess {
+
+static constexpr std::uint64_t DEPTH_MASK = 0xFF;
+
+// Entries of a file table are read and written by several processes.
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free);
+
+// ------------------------------------------------------------
+// File format
+// ------------------------------------------------------------
+//
+// A 64-byte header followed by bucket_count buckets, exactly as they sit
+// in memory. build_id identifies the move generator, perft driver and
+// Zobrist keys that produced the counts (the Makefile checksums their
+// sources and perft_table.h); bump FILE_FORMAT when the layout changes.
+
+static constexpr std::uint64_t FILE_FORMAT = 1;
+static constexpr char FILE_MAGIC[8] = {'C', 'H', 'P', 'E', 'R', 'F', 'T', '\0'};
+
+struct FileHeader {
+    char magic[8];
+    std::uint64_t build_id;
+    std::uint64_t bucket_count;
+    char reserved[40];
+};
+static_assert(sizeof(FileHeader) == 64);
+
+static std::uint64_t mix(std::uint64_t h, std::uint64_t v) {
+    h ^= v + 0x9E3779B97F4A7C15ull + (h << 6) + (h >> 2);
+    h ^= h >> 31;
+    h *= 0xBF58476D1CE4E5B9ull;
+    return h ^ (h >> 29);
+}
+
+// CHESS_MOVEGEN_BUILD_ID is a checksum of the move generator sources,
+// passed in by the Makefile. Without it only files written by this very
+// compile are trusted.
+static std::uint64_t movegen_build_id() {
+#ifdef CHESS_MOVEGEN_BUILD_ID
+    std::uint64_t h = mix(FILE_FORMAT, CHESS_MOVEGEN_BUILD_ID);
+#else
+    std::uint64_t h = FILE_FORMAT;
+    for (const char* p = __DATE__ " " __TIME__; *p; ++p) h = mix(h, static_cast<unsigned char>(*p));
+#endif
+    h = mix(h, zobrist_keys.side);
+    h = mix(h, zobrist_keys.piece[1][0]);
+    return h == 0 ? 1 : h;
+}
+
+// Largest power-of-two bucket count fitting in `mb` megabytes (0 for 0).
+static std::size_t bucket_count_for(std::size_t mb, std::size_t bucket_size) {
+    if (mb == 0) return 0;
+    const std::size_t max_buckets = (mb << 20) / bucket_size;
+    std::size_t count = 1;
+    while (count * 2 <= max_buckets) count *= 2;
+    return count;
+}
+
+// ------------------------------------------------------------
+
+PerftTable::~PerftTable() {
+    release();
+}
+
+void PerftTable::release() {
+    if (map_) ::munmap(map_, map_bytes_);
+    map_ = nullptr;
+    map_bytes_ = 0;
+    heap_.reset();
+    buckets_ = nullptr;
+    bucket_count_ = 0;
+    salt_ = 0;
+}
+
+void PerftTable::resize(std::size_t mb) {
+    release();
+
+    const std::size_t count = bucket_count_for(mb, sizeof(Bucket));
+    if (count == 0) return;
+
+    heap_ = std::make_unique<Bucket[]>(count); // value-initialized: all entries empty
+    buckets_ = heap_.get();
+    bucket_count_ = count;
+}
+
+// Writes a fresh `bytes`-byte file of `count` empty buckets next to `path` and renames
+// it into place, returning it open read-write (-1 on error). Processes that
+// still map the old file keep its inode, so they never see it shrink.
+static int replace_file(const std::string& path, std::size_t count, std::size_t bytes, std::uint64_t build,
+                        std::string& error) {
+    const std::string tmp = path + "." + std::to_string(::getpid()) + ".tmp";
+    const int fd = ::open(tmp.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        error = tmp + ": " + std::strerror(errno);
+        return -1;
+    }
+
+    FileHeader header{};
+    std::memcpy(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+    header.build_id = build;
+    header.bucket_count = count;
+
+    // ftruncate zero-fills: every entry starts empty.
+    if (::ftruncate(fd, static_cast<off_t>(bytes)) != 0 ||
+        ::pwrite(fd, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header)) ||
+        ::rename(tmp.c_str(), path.c_str()) != 0) {
+        error = path + ": " + std::strerror(errno);
+        ::close(fd);
+        ::unlink(tmp.c_str());
+        return -1;
+    }
+    return fd;
+}
+
+bool PerftTable::open_file(const std::string& path, std::size_t mb, std::string& error) {
+    release();
+
+    // Processes opening the same file at once must not both initialize it.
+    // The lock is on the inode, so if another process replaced the file
+    // while we waited, retry on the new one.
+    int fd = -1;
+    struct stat st{};
+    while (true) {
+        fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+        if (fd < 0) {
+            error = path + ": " + std::strerror(errno);
+            return false;
+        }
+        ::flock(fd, LOCK_EX);
+
+        struct stat current{};
+        if (::fstat(fd, &st) != 0) {
+            error = path + ": " + std::strerror(errno);
+            ::close(fd);
+            return false;
+        }
+        if (::stat(path.c_str(), &current) == 0 && current.st_dev == st.st_dev && current.st_ino == st.st_ino) break;
+        ::close(fd);
+    }
+
+    const std::uint64_t build = movegen_build_id();
+    std::size_t count = 0;
+    bool wipe = false;
+
+    FileHeader header{};
+    const bool readable = static_cast<std::size_t>(st.st_size) >= sizeof(FileHeader) &&
+                          ::pread(fd, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header));
+    const bool valid = readable && std::memcmp(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC)) == 0 &&
+                       header.bucket_count != 0 && (header.bucket_count & (header.bucket_count - 1)) == 0 &&
+                       static_cast<std::size_t>(st.st_size) == sizeof(FileHeader) + header.bucket_count * sizeof(Bucket);
+
+    if (valid) {
+        // Foreign or stale counts are wiped in place below, keeping the
+        // file's size so that other mappings of it stay valid.
+        count = header.bucket_count;
+        wipe = header.build_id != build;
+    } else {
+        // New or malformed: replace it with a fresh file.
+        count = bucket_count_for(mb, sizeof(Bucket));
+        if (count == 0) {
+            error = path + ": no usable perft cache and no size given";
+        } else {
+            const int fresh = replace_file(path, count, sizeof(FileHeader) + count * sizeof(Bucket), build, error);
+            if (fresh < 0) {
+                count = 0;
+            } else {
+                ::flock(fd, LOCK_UN);
+                ::close(fd);
+                fd = fresh;
+            }
+        }
+    }
+
+    void* map = MAP_FAILED;
+    const std::size_t bytes = sizeof(FileHeader) + count * sizeof(Bucket);
+    if (count != 0) {
+        map = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (map == MAP_FAILED) error = path + ": " + std::strerror(errno);
+    }
+
+    if (map != MAP_FAILED) {
+        map_ = map;
+        map_bytes_ = bytes;
+        buckets_ = reinterpret_cast<Bucket*>(static_cast<char*>(map) + sizeof(FileHeader));
+        bucket_count_ = count;
+        if (wipe) {
+            clear();
+            FileHeader fresh{};
+            std::memcpy(fresh.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+            fresh.build_id = build;
+            fresh.bucket_count = count;
+            std::memcpy(map, &fresh, sizeof(fresh));
+        }
+    }
+
+    ::flock(fd, LOCK_UN);
+    ::close(fd); // the mapping stays valid
+
+    if (map == MAP_FAILED) return false;
+
+    // A process still running an older build may keep writing into a file
+    // that was just wiped; salting the keys with the build id means its
+    // entries can never match ours.
+    salt_ = build;
+    return true;
+}
+
+void PerftTable::clear() {
+    for (std::size_t i = 0; i < bucket_count_; ++i) {
+        for (Entry& e : buckets_[i].entries) {
+            e.check.store(0, std::memory_order_relaxed);
+            e.data.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+bool PerftTable::probe(std::uint64_t key, int depth, std::uint64_t& nodes) const {
+    if (!enabled()) return false;
+    key ^= salt_;
+
+    for (const Entry& e : bucket(key).entries) {
+        const std::uint64_t data = e.data.load(std::memory_order_relaxed);
+        const std::uint64_t check = e.check.load(std::memory_order_relaxed);
+        if ((check ^ data) == key && (data & DEPTH_MASK) == static_cast<std::uint64_t>(depth)) {
+            nodes = data >> 8;
+            return true;
+        }
+    }
+    return false;
+}
+
+void PerftTable::store(std::uint64_t key, int depth, std::uint64_t nodes) {
+    if (!enabled()) return;
+    key ^= salt_;
+
+    // Replace the shallowest entry in the bucket: deeper subtrees cost more
+    // to recompute. Empty entries have depth 0 and go first.
+    Entry* victim = nullptr;
+    std::uint64_t victim_depth = ~0ull;
+    for (Entry& e : bucket(key).entries) {
+        const std::uint64_t data = e.data.load(std::memory_order_relaxed);
+        const std::uint64_t d = data & DEPTH_MASK;
+        if ((e.check.load(std::memory_order_relaxed) ^ data) == key && d == static_cast<std::uint64_t>(depth)) {
+            return; // already present
+        }
+        if (d < victim_depth) {
+            victim = &e;
+            victim_depth = d;
+        }
+    }
+
+    const std::uint64_t data = (nodes << 8) | static_cast<std::uint64_t>(depth);
+    victim->check.store(key ^ data, std::memory_order_relaxed);
+    victim->data.store(data, std::memory_order_relaxed);
+}
+
+} // namespace chess
@@ -9,6 +9,9 @@ Position::Position() {
     // stm_, castling_, ep_sq_, halfmove_, fullmove_ already defaulted
     king_sq_[WHITE] = 0; // a1 placeholder until set
     king_sq_[BLACK] = 0;
+
+    // Empty board, white to move, no castling rights, no ep square.
+    key_ = zobrist_castling(castling_) ^ zobrist_ep(ep_sq_);
 }
 
 Piece Position::at(int sq) const {
@@ -18,8 +21,25 @@ Piece Position::at(int sq) const {
 
 void Position::set_piece(int sq, Piece p) {
     if (!is_valid_square(sq)) return;
+
+    const Bitboard bb = square_bb(sq);
+
+    // Clear whatever was on the square from the bitboards first.
+    Piece old = board_[static_cast<size_t>(sq)];
+    if (old != EMPTY) {
+        by_type_[piece_type(old)] &= ~bb;
+        by_color_[piece_color(old)] &= ~bb;
+        key_ ^= zobrist_piece(old, sq);
+    }
+
     board_[static_cast<size_t>(sq)] = p;
 
+    if (p != EMPTY) {
+        by_type_[piece_type(p)] |= bb;
+        by_color_[piece_color(p)] |= bb;
+        key_ ^= zobrist_piece(p, sq);
+    }
+
     // Maintain king cache if a king is placed/removed.
     if (p == WK) king_sq_[WHITE] = static_cast<uint8_t>(sq);
     else if (p == BK) king_sq_[BLACK] = static_cast<uint8_t>(sq);
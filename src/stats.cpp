@@ -0,0 +1,108 @@
+#include "chess/stats.h"
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace chess {
+
+const char* stat_name(Stat s) {
+    switch (s) {
+        case STAT_GENERATE_LEGAL: return "generate_legal";
+        case STAT_COUNT_LEGAL: return "count_legal";
+        case STAT_GENERATE_PSEUDO_LEGAL: return "generate_pseudo_legal";
+        case STAT_MAKE_MOVE: return "make_move";
+        case STAT_UNDO_MOVE: return "undo_move";
+        case STAT_IS_SQUARE_ATTACKED: return "is_square_attacked";
+        case STAT_ZOBRIST_KEY: return "zobrist_key";
+        case STAT_ILLEGAL_REJECTED: return "illegal_rejected";
+        case STAT_COUNT: break;
+    }
+    return "?";
+}
+
+#ifdef CHESS_STATS
+
+namespace {
+
+// Blocks of live threads, plus the totals of threads that have exited.
+struct Registry {
+    std::mutex mutex;
+    std::vector<detail::StatBlock*> live;
+    StatCounts retired{};
+};
+
+Registry& registry() {
+    static Registry r; // outlives every thread that registers with it
+    return r;
+}
+
+// Owns the calling thread's block; folds it into the retired totals when
+// the thread exits.
+struct ThreadStats {
+    std::unique_ptr<detail::StatBlock> block;
+
+    ~ThreadStats() {
+        if (!block) return;
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        for (int s = 0; s < STAT_COUNT; ++s) r.retired[s] += block->count[s].load(std::memory_order_relaxed);
+        r.live.erase(std::find(r.live.begin(), r.live.end(), block.get()));
+        detail::tl_stats = nullptr;
+    }
+};
+
+thread_local ThreadStats tl_thread_stats;
+
+} // namespace
+
+namespace detail {
+
+constinit thread_local StatBlock* tl_stats = nullptr;
+
+StatBlock* register_stats_thread() {
+    Registry& r = registry();
+    tl_thread_stats.block = std::make_unique<StatBlock>();
+    {
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.live.push_back(tl_thread_stats.block.get());
+    }
+    tl_stats = tl_thread_stats.block.get();
+    return tl_stats;
+}
+
+} // namespace detail
+
+StatCounts stats_snapshot() {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    StatCounts total = r.retired;
+    for (const detail::StatBlock* block : r.live) {
+        for (int s = 0; s < STAT_COUNT; ++s) total[s] += block->count[s].load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+void stats_reset() {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.retired.fill(0);
+    // Increments racing with this may survive it; counts are only exact
+    // while no other thread is counting.
+    for (detail::StatBlock* block : r.live) {
+        for (auto& c : block->count) c.store(0, std::memory_order_relaxed);
+    }
+}
+
+#else
+
+StatCounts stats_snapshot() {
+    return {};
+}
+
+void stats_reset() {}
+
+#endif
+
+} // namespace chess
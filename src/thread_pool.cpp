@@ -0,0 +1,108 @@
+#include "chess/thread_pool.h"
+
+#include <string>
+
+#include "chess/trace.h"
+
+namespace chess {
+
+// Which pool (if any) the current thread works for, and its queue index.
+static thread_local const ThreadPool* tl_pool = nullptr;
+static thread_local unsigned tl_worker = 0;
+
+ThreadPool::ThreadPool(unsigned threads) {
+    if (threads == 0) threads = 1;
+
+    for (unsigned i = 0; i < threads; ++i) queues_.push_back(std::make_unique<Queue>());
+    for (unsigned i = 0; i < threads; ++i) workers_.emplace_back([this, i] { worker_loop(i); });
+}
+
+ThreadPool::~ThreadPool() {
+    wait();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    work_cv_.notify_all();
+    for (auto& t : workers_) t.join();
+}
+
+void ThreadPool::submit(Task task) {
+    const unsigned q = (tl_pool == this)
+        ? tl_worker
+        : next_queue_.fetch_add(1, std::memory_order_relaxed) % size();
+
+    // Count before publishing (so a pop never sees the count go negative),
+    // and under mutex_ so a worker deciding to sleep cannot miss it.
+    pending_.fetch_add(1);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queued_.fetch_add(1);
+    }
+    {
+        std::lock_guard<std::mutex> lock(queues_[q]->mutex);
+        queues_[q]->tasks.push_back(std::move(task));
+    }
+    work_cv_.notify_one();
+}
+
+bool ThreadPool::try_pop(unsigned id, Task& out) {
+    // Own deque first, newest task.
+    {
+        Queue& own = *queues_[id];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            out = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+
+    // Then steal the oldest task from the others.
+    for (unsigned k = 1; k < size(); ++k) {
+        Queue& victim = *queues_[(id + k) % size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            out = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::worker_loop(unsigned id) {
+    tl_pool = this;
+    tl_worker = id;
+    trace_thread_name("pool worker " + std::to_string(id));
+
+    while (true) {
+        Task task;
+        if (try_pop(id, task)) {
+            queued_.fetch_sub(1);
+            task();
+
+            if (pending_.fetch_sub(1) == 1) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                done_cv_.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        work_cv_.wait(lock, [this] { return stop_ || queued_.load() > 0; });
+        if (stop_ && queued_.load() == 0) return;
+    }
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_cv_.wait(lock, [this] { return pending_.load() == 0; });
+}
+
+unsigned hardware_threads() {
+    const unsigned n = std::thread::hardware_concurrency();
+    return n == 0 ? 1 : n;
+}
+
+} // namespace chess
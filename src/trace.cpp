@@ -0,0 +1,200 @@
+#include "chess/trace.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace chess {
+
+namespace detail {
+
+std::atomic<bool> trace_on{false};
+
+} // namespace detail
+
+namespace {
+
+struct TraceEvent {
+    const char* name;
+    char detail[32];
+    std::int64_t begin_ns; // since the trace started
+    std::int64_t dur_ns;
+};
+
+// One thread's events. Only that thread appends; the lock is taken by the
+// writer of the trace, so it is practically never contended.
+struct TraceRing {
+    std::mutex mutex;
+    int tid = 0;
+    std::string thread_name;
+    std::vector<TraceEvent> events; // grows up to TRACE_RING_EVENTS, then wraps
+    std::size_t next = 0;           // oldest event once the ring is full
+    std::uint64_t dropped = 0;
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex);
+        events.clear();
+        next = 0;
+        dropped = 0;
+    }
+};
+
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::shared_ptr<TraceRing>> rings; // kept after their thread exits
+    int next_tid = 1;
+    std::string path;
+    bool exit_hook = false;
+};
+
+Registry& registry() {
+    static Registry* r = new Registry; // never destroyed: written from an atexit hook
+    return *r;
+}
+
+std::atomic<std::int64_t> g_origin_ns{0};
+
+thread_local std::shared_ptr<TraceRing> tl_ring;
+
+std::int64_t now_ns(std::chrono::steady_clock::time_point t) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count();
+}
+
+TraceRing& this_ring() {
+    if (!tl_ring) {
+        auto ring = std::make_shared<TraceRing>();
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        ring->tid = r.next_tid++;
+        ring->thread_name = "thread " + std::to_string(ring->tid);
+        r.rings.push_back(ring);
+        tl_ring = std::move(ring);
+    }
+    return *tl_ring;
+}
+
+std::string json_string(const std::string& s) {
+    std::string out = "\"";
+    for (char c : s) {
+        if (c == '"' || c == '\\') out += '\\';
+        if (static_cast<unsigned char>(c) < 0x20) c = ' ';
+        out += c;
+    }
+    return out + "\"";
+}
+
+std::string json_us(std::int64_t ns) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.3f", static_cast<double>(ns) / 1000.0);
+    return buf;
+}
+
+void write_at_exit() {
+    if (!trace_enabled()) return;
+    std::string error;
+    if (!trace_stop(error)) std::cerr << "Could not write trace: " << error << "\n";
+}
+
+} // namespace
+
+namespace detail {
+
+void trace_record(const char* name, const char* detail, std::chrono::steady_clock::time_point begin) {
+    const std::int64_t end_ns = now_ns(std::chrono::steady_clock::now());
+    if (!trace_on.load(std::memory_order_acquire)) return; // stopped meanwhile
+
+    const std::int64_t origin = g_origin_ns.load(std::memory_order_relaxed);
+    TraceEvent e;
+    e.name = name;
+    std::copy(detail, detail + sizeof(e.detail), e.detail);
+    e.begin_ns = std::max<std::int64_t>(now_ns(begin) - origin, 0);
+    e.dur_ns = std::max<std::int64_t>(end_ns - origin - e.begin_ns, 0);
+
+    TraceRing& ring = this_ring();
+    std::lock_guard<std::mutex> lock(ring.mutex);
+    if (ring.events.size() < TRACE_RING_EVENTS) {
+        ring.events.push_back(e);
+    } else {
+        ring.events[ring.next] = e;
+        ring.next = (ring.next + 1) % TRACE_RING_EVENTS;
+        ++ring.dropped;
+    }
+}
+
+} // namespace detail
+
+bool trace_start(const std::string& path, std::string& error) {
+    if (!std::ofstream(path)) {
+        error = "cannot write " + path;
+        return false;
+    }
+
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    detail::trace_on.store(false, std::memory_order_relaxed);
+
+    // Rings only the registry still holds belong to threads that have exited.
+    std::erase_if(r.rings, [](const std::shared_ptr<TraceRing>& ring) { return ring.use_count() == 1; });
+    for (const auto& ring : r.rings) ring->clear();
+
+    r.path = path;
+    if (!r.exit_hook) {
+        std::atexit(write_at_exit);
+        r.exit_hook = true;
+    }
+    g_origin_ns.store(now_ns(std::chrono::steady_clock::now()), std::memory_order_relaxed);
+    detail::trace_on.store(true, std::memory_order_release);
+    return true;
+}
+
+bool trace_stop(std::string& error) {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    if (!detail::trace_on.exchange(false)) {
+        error = "not tracing";
+        return false;
+    }
+
+    std::ofstream out(r.path);
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    const char* sep = "";
+    std::uint64_t dropped = 0;
+    for (const auto& ring : r.rings) {
+        std::lock_guard<std::mutex> ring_lock(ring->mutex);
+        const std::string tid = std::to_string(ring->tid);
+        out << sep << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid
+            << ",\"args\":{\"name\":" << json_string(ring->thread_name) << "}}";
+        sep = ",\n";
+        out << sep << "{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid
+            << ",\"args\":{\"sort_index\":" << tid << "}}";
+
+        for (const TraceEvent& e : ring->events) {
+            out << sep << "{\"name\":" << json_string(e.name) << ",\"cat\":\"chess\",\"ph\":\"X\",\"pid\":1,\"tid\":"
+                << tid << ",\"ts\":" << json_us(e.begin_ns) << ",\"dur\":" << json_us(e.dur_ns);
+            if (e.detail[0]) out << ",\"args\":{\"detail\":" << json_string(e.detail) << "}";
+            out << "}";
+        }
+        dropped += ring->dropped;
+    }
+    out << "\n],\"otherData\":{\"dropped_events\":" << dropped << "}}\n";
+
+    if (!out) {
+        error = "cannot write " + r.path;
+        return false;
+    }
+    return true;
+}
+
+void trace_thread_name(const std::string& name) {
+    if (!trace_enabled()) return;
+    TraceRing& ring = this_ring();
+    std::lock_guard<std::mutex> lock(ring.mutex);
+    ring.thread_name = name;
+}
+
+} // namespace chess
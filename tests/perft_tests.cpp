@@ -1,20 +1,34 @@
+#include <algorithm>
+#include <cctype>
 #include <cstdint>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <mutex>
+#include <numeric>
 #include <sstream>
+#include <stdexcept>
 #include <string>
 #include <string_view>
 #include <vector>
 #include <chrono>
 
+#include "chess/alloc_stats.h"
 #include "chess/fen.h"
+#include "chess/magic.h"
 #include "chess/perft.h"
 #include "chess/position.h"
+#include "chess/thread_pool.h"
+#include "chess/trace.h"
 
+// One position with the node counts to verify at one or more depths.
+// All depths of a case are checked from a single perft_by_depth traversal.
 struct TestCase {
     std::string fen;
-    int depth = 0;
-    std::uint64_t expected = 0;
+    std::vector<std::pair<int, std::uint64_t>> checks; // (depth, expected nodes), ascending depth
+
+    int max_depth() const { return checks.empty() ? 0 : checks.back().first; }
+    std::uint64_t largest_expected() const { return checks.empty() ? 0 : checks.back().second; }
 };
 
 static inline std::string trim(std::string s) {
@@ -24,19 +38,64 @@ static inline std::string trim(std::string s) {
     return s;
 }
 
-static bool split3(const std::string& line, std::string& a, std::string& b, std::string& c) {
-    size_t p1 = line.find(';');
-    if (p1 == std::string::npos) return false;
-    size_t p2 = line.find(';', p1 + 1);
-    if (p2 == std::string::npos) return false;
+static std::vector<std::string> split_fields(const std::string& line) {
+    std::vector<std::string> out;
+    size_t start = 0;
+    while (true) {
+        size_t p = line.find(';', start);
+        std::string field = trim(line.substr(start, p == std::string::npos ? std::string::npos : p - start));
+        if (!field.empty()) out.push_back(std::move(field));
+        if (p == std::string::npos) break;
+        start = p + 1;
+    }
+    return out;
+}
+
+// EPD operations look like "D5 4865609".
+static bool is_epd_depth_field(const std::string& f) {
+    return f.size() >= 2 && f[0] == 'D' && std::isdigit(static_cast<unsigned char>(f[1]));
+}
+
+// Accepts two line formats:
+//   FEN ; depth ; nodes               (one depth per line)
+//   FEN ;D1 n1 ;D2 n2 ;...            (EPD perft suite, e.g. data/perftsuite.epd)
+// EPD positions may omit the halfmove/fullmove fields. Consecutive lines
+// for the same FEN are merged into one case.
+static bool parse_line(const std::string& line, std::string& fen,
+                       std::vector<std::pair<int, std::uint64_t>>& checks) {
+    const auto fields = split_fields(line);
+    if (fields.size() < 2) return false;
+
+    fen = fields[0];
+    checks.clear();
+
+    try {
+        if (is_epd_depth_field(fields[1])) {
+            if (std::count(fen.begin(), fen.end(), ' ') == 3) fen += " 0 1";
+
+            for (size_t i = 1; i < fields.size(); ++i) {
+                const std::string& f = fields[i];
+                if (!is_epd_depth_field(f)) continue; // ignore other EPD operations
+                size_t used = 0;
+                const int depth = std::stoi(f.substr(1), &used);
+                const std::uint64_t nodes = std::stoull(f.substr(1 + used));
+                checks.emplace_back(depth, nodes);
+            }
+        } else {
+            if (fields.size() != 3) return false;
+            checks.emplace_back(std::stoi(fields[1]), static_cast<std::uint64_t>(std::stoull(fields[2])));
+        }
+    } catch (...) {
+        return false;
+    }
 
-    a = trim(line.substr(0, p1));
-    b = trim(line.substr(p1 + 1, p2 - (p1 + 1)));
-    c = trim(line.substr(p2 + 1));
-    return !(a.empty() || b.empty() || c.empty());
+    for (const auto& [depth, nodes] : checks) {
+        if (depth < 1) return false;
+    }
+    return !checks.empty();
 }
 
-static bool load_suite(const std::string& path, std::vector<TestCase>& out) {
+static bool load_suite(const std::string& path, int max_depth, std::vector<TestCase>& out) {
     std::ifstream in(path);
     if (!in) return false;
 
@@ -47,25 +106,27 @@ static bool load_suite(const std::string& path, std::vector<TestCase>& out) {
         line = trim(line);
         if (line.empty() || line[0] == '#') continue;
 
-        std::string fen, depth_s, nodes_s;
-        if (!split3(line, fen, depth_s, nodes_s)) {
-            std::cerr << "Bad line (expected: FEN ; depth ; nodes): " << line << "\n";
+        std::string fen;
+        std::vector<std::pair<int, std::uint64_t>> checks;
+        if (!parse_line(line, fen, checks)) {
+            std::cerr << "Bad line (expected: FEN ; depth ; nodes  or  FEN ;D1 n ;D2 n ...): "
+                      << line << "\n";
             return false;
         }
 
-        TestCase tc;
-        tc.fen = fen;
-        try {
-            tc.depth = std::stoi(depth_s);
-            tc.expected = static_cast<std::uint64_t>(std::stoull(nodes_s));
-        } catch (...) {
-            std::cerr << "Bad numbers in line: " << line << "\n";
-            return false;
+        if (max_depth > 0) {
+            std::erase_if(checks, [&](const auto& c) { return c.first > max_depth; });
+            if (checks.empty()) continue;
         }
 
-        out.push_back(std::move(tc));
+        if (out.empty() || out.back().fen != fen) {
+            out.push_back(TestCase{fen, {}});
+        }
+        auto& merged = out.back().checks;
+        merged.insert(merged.end(), checks.begin(), checks.end());
     }
 
+    for (auto& tc : out) std::sort(tc.checks.begin(), tc.checks.end());
     return true;
 }
 
@@ -75,66 +136,282 @@ static void print_progress(size_t done, size_t total) {
     std::cout << "\r[" << done << "/" << total << "] " << pct << "% complete" << std::flush;
 }
 
+struct CaseResult {
+    bool fen_ok = true;
+    std::vector<std::uint64_t> got; // got[d - 1] = nodes at depth d
+    double ms = 0.0;
+
+    std::uint64_t at(int depth) const { return got[static_cast<size_t>(depth - 1)]; }
+    std::uint64_t leaves() const { return got.empty() ? 0 : got.back(); }
+};
+
+static double mnps(std::uint64_t nodes, double ms) {
+    return ms > 0.0 ? static_cast<double>(nodes) / (ms * 1000.0) : 0.0;
+}
+
+static CaseResult run_case(const TestCase& tc, chess::PerftTable* cache) {
+    CaseResult r;
+
+    chess::Position pos;
+    if (!chess::from_fen(tc.fen, pos)) {
+        r.fen_ok = false;
+        return r;
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    if (cache) {
+        // One cached perft per checked depth: on a warm cache each is a
+        // single lookup, which beats any traversal.
+        r.got.assign(static_cast<size_t>(tc.max_depth()), 0);
+        for (const auto& [depth, expected] : tc.checks) {
+            r.got[static_cast<size_t>(depth - 1)] = chess::perft(pos, depth, cache);
+        }
+    } else {
+        r.got = chess::perft_by_depth(pos, tc.max_depth());
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    r.ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+    return r;
+}
+
+static bool case_passed(const TestCase& tc, const CaseResult& r) {
+    if (!r.fen_ok) return false;
+    for (const auto& [depth, expected] : tc.checks) {
+        if (r.at(depth) != expected) return false;
+    }
+    return true;
+}
+
+static void print_usage() {
+    std::cerr << "Usage: perft_tests [--jobs N] [--max-depth D] [--cache FILE [--cache-mb MB]] [--trace FILE]\n"
+              << "                   [--verbose] <path_to_suite>\n"
+              << "  --jobs N       run N cases concurrently, largest expected node counts first\n"
+              << "  --max-depth D  skip expected counts deeper than D\n"
+              << "  --cache FILE   keep subtree counts in FILE across runs (shared with other processes)\n"
+              << "  --cache-mb MB  size of a newly created cache file (default 256)\n"
+              << "  --trace FILE   write a Chrome trace-event timeline of the cases to FILE\n"
+              << "  --verbose      print every case with its wall time and nodes/sec\n"
+              << "Suites are 'FEN ; depth ; nodes' lines or EPD lines 'FEN ;D1 n ;D2 n ...'.\n";
+}
+
 int main(int argc, char** argv) {
-    if (argc < 2) {
-        std::cerr << "Usage: perft_tests <path_to_suite>\n";
-        return 2;
+    unsigned jobs = 1;
+    int max_depth = 0;
+    bool verbose = false;
+    std::string path;
+    std::string cache_path;
+    size_t cache_mb = 256;
+    std::string trace_path;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--jobs" && i + 1 < argc) {
+            try {
+                const int n = std::stoi(argv[++i]);
+                if (n < 1) throw std::out_of_range("jobs");
+                jobs = static_cast<unsigned>(n);
+            } catch (...) {
+                print_usage();
+                return 2;
+            }
+        } else if (arg == "--max-depth" && i + 1 < argc) {
+            try {
+                max_depth = std::stoi(argv[++i]);
+                if (max_depth < 1) throw std::out_of_range("max-depth");
+            } catch (...) {
+                print_usage();
+                return 2;
+            }
+        } else if (arg == "--cache" && i + 1 < argc) {
+            cache_path = argv[++i];
+        } else if (arg == "--trace" && i + 1 < argc) {
+            trace_path = argv[++i];
+        } else if (arg == "--cache-mb" && i + 1 < argc) {
+            try {
+                const int mb = std::stoi(argv[++i]);
+                if (mb < 1) throw std::out_of_range("cache-mb");
+                cache_mb = static_cast<size_t>(mb);
+            } catch (...) {
+                print_usage();
+                return 2;
+            }
+        } else if (arg == "--verbose" || arg == "-v") {
+            verbose = true;
+        } else if (path.empty() && !arg.starts_with("--")) {
+            path = arg;
+        } else {
+            print_usage();
+            return 2;
+        }
     }
 
-    const std::string path = argv[1];
+    if (path.empty()) {
+        print_usage();
+        return 2;
+    }
 
     std::vector<TestCase> tests;
-    if (!load_suite(path, tests)) {
+    if (!load_suite(path, max_depth, tests)) {
         std::cerr << "Failed to load suite: " << path << "\n";
         return 2;
     }
 
-    std::cout << "Loaded " << tests.size() << " perft tests from " << path << "\n";
+    chess::PerftTable cache;
+    if (!cache_path.empty()) {
+        std::string error;
+        if (!cache.open_file(cache_path, cache_mb, error)) {
+            std::cerr << "Failed to open perft cache: " << error << "\n";
+            return 2;
+        }
+    }
+    chess::PerftTable* cache_ptr = cache.enabled() ? &cache : nullptr;
+
+    if (!trace_path.empty()) {
+        std::string error;
+        if (!chess::trace_start(trace_path, error)) {
+            std::cerr << "Failed to start trace: " << error << "\n";
+            return 2;
+        }
+        chess::trace_thread_name("main");
+    }
+
+    size_t total_checks = 0;
+    for (const auto& tc : tests) total_checks += tc.checks.size();
+
+    std::cout << "Loaded " << total_checks << " perft tests (" << tests.size()
+              << " positions) from " << path
+              << " (sliders: " << chess::slider_backend_name(chess::slider_backend())
+              << ", jobs: " << jobs;
+    if (cache_ptr) std::cout << ", cache: " << cache_path << " " << cache.size_mb() << " MB";
+    std::cout << ")\n";
 
     const size_t total = tests.size();
-    size_t passed = 0;
+
+    // With several jobs, start the biggest cases first so one long case
+    // does not end up running alone at the end.
+    std::vector<size_t> order(total);
+    std::iota(order.begin(), order.end(), size_t{0});
+    if (jobs > 1) {
+        std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            return tests[a].largest_expected() > tests[b].largest_expected();
+        });
+    }
+
+    std::vector<CaseResult> results(total);
+    std::mutex out_mutex;
+    size_t done = 0;
 
     // Print progress every N tests (tune as you like)
     const size_t progress_every = 5;
 
+    auto finish = [&](size_t i) {
+        std::lock_guard<std::mutex> lock(out_mutex);
+        ++done;
+        if (verbose) {
+            const auto& tc = tests[i];
+            const auto& r = results[i];
+            std::cout << "[" << done << "/" << total << "] "
+                      << (case_passed(tc, r) ? "ok   " : "FAIL ")
+                      << "#" << (i + 1) << " depth " << tc.max_depth()
+                      << " nodes " << r.leaves() << " " << std::fixed << std::setprecision(1)
+                      << r.ms << " ms " << mnps(r.leaves(), r.ms) << " Mnps  " << tc.fen << "\n";
+        } else if (done % progress_every == 0 || done == total) {
+            print_progress(done, total);
+        }
+    };
+
+    auto run = [&](size_t i) {
+        chess::TraceScope scope("perft case", "#" + std::to_string(i + 1));
+        results[i] = run_case(tests[i], cache_ptr);
+    };
+
+    const chess::AllocScope allocs;
     auto t0 = std::chrono::steady_clock::now();
-    print_progress(0, total);
+    if (!verbose) print_progress(0, total);
+
+    if (jobs > 1) {
+        chess::ThreadPool pool(jobs);
+        for (size_t i : order) {
+            pool.submit([&, i] {
+                run(i);
+                finish(i);
+            });
+        }
+        pool.wait();
+    } else {
+        for (size_t i : order) {
+            run(i);
+            finish(i);
+        }
+    }
+
+    auto t1 = std::chrono::steady_clock::now();
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0).count();
+    if (!verbose) std::cout << "\n";
+
+    if (!trace_path.empty()) {
+        std::string error;
+        if (chess::trace_stop(error))
+            std::cout << "Trace written to " << trace_path << "\n";
+        else
+            std::cerr << "Failed to write trace: " << error << "\n";
+    }
+
+    // Report every failure, in suite order.
+    size_t passed = 0;
+    bool parse_error = false;
+    std::uint64_t total_nodes = 0;
+    double case_ms = 0.0;
 
     for (size_t i = 0; i < total; ++i) {
         const auto& tc = tests[i];
+        const auto& r = results[i];
+        total_nodes += r.leaves();
+        case_ms += r.ms;
 
-        chess::Position pos;
-        if (!chess::from_fen(tc.fen, pos)) {
-            std::cout << "\n";
+        if (!r.fen_ok) {
+            parse_error = true;
             std::cerr << "FEN parse failed at test " << (i + 1) << ":\n" << tc.fen << "\n";
-            return 2;
+            continue;
         }
 
-        chess::Position copy = pos;
-        std::uint64_t got = chess::perft(copy, tc.depth);
-
-        if (got != tc.expected) {
-            std::cout << "\n";
+        for (const auto& [depth, expected] : tc.checks) {
+            if (r.at(depth) == expected) {
+                ++passed;
+                continue;
+            }
             std::cerr << "FAIL test " << (i + 1) << "/" << total << "\n";
-            std::cerr << "  depth:    " << tc.depth << "\n";
+            std::cerr << "  depth:    " << depth << "\n";
             std::cerr << "  FEN:      " << tc.fen << "\n";
-            std::cerr << "  expected: " << tc.expected << "\n";
-            std::cerr << "  got:      " << got << "\n";
-            return 1;
+            std::cerr << "  expected: " << expected << "\n";
+            std::cerr << "  got:      " << r.at(depth) << "\n";
         }
+    }
 
-        ++passed;
+    // Slowest cases: the ones to look at when the suite gets slower.
+    std::vector<size_t> slowest(total);
+    std::iota(slowest.begin(), slowest.end(), size_t{0});
+    std::sort(slowest.begin(), slowest.end(),
+              [&](size_t a, size_t b) { return results[a].ms > results[b].ms; });
+    slowest.resize(std::min<size_t>(slowest.size(), 5));
 
-        // Progress output
-        if ((i + 1) % progress_every == 0 || (i + 1) == total) {
-            print_progress(i + 1, total);
-        }
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "Slowest cases:\n";
+    for (size_t i : slowest) {
+        std::cout << "  #" << (i + 1) << " depth " << tests[i].max_depth() << ": "
+                  << results[i].ms << " ms, " << mnps(results[i].leaves(), results[i].ms) << " Mnps  "
+                  << tests[i].fen << "\n";
+    }
+    std::cout << "Nodes: " << total_nodes << " (" << mnps(total_nodes, case_ms)
+              << " Mnps per job)\n";
+    if (chess::alloc_stats_enabled) {
+        const chess::AllocCounts a = allocs.counts();
+        std::cout << "Allocations: " << a.allocations << " (" << a.per_node(total_nodes) << ")\n";
     }
 
-    auto t1 = std::chrono::steady_clock::now();
-    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0).count();
-
-    std::cout << "\nPerft tests passed: " << passed << "/" << total
+    std::cout << "Perft tests passed: " << passed << "/" << total_checks
               << " in " << ms << " ms\n";
-    return 0;
-}
\ No newline at end of file
+
+    if (parse_error) return 2;
+    return passed == total_checks ? 0 : 1;
+}
@@ -1,14 +1,32 @@
+#include <algorithm>
 #include <cassert>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <sstream>
 #include <string>
+#include <thread>
+#include <vector>
 
+#include "chess/alloc_stats.h"
+#include "chess/attack.h"
+#include "chess/bench.h"
 #include "chess/fen.h"
+#include "chess/magic.h"
 #include "chess/makemove.h"
 #include "chess/movegen.h"
+#include "chess/perf_counters.h"
+#include "chess/perft.h"
+#include "chess/perft_dist.h"
+#include "chess/perft_table.h"
 #include "chess/position.h"
+#include "chess/stats.h"
+#include "chess/trace.h"
 #include "chess/undo.h"
 #include "chess/game.h"
 #include "chess/rules.h"
+#include "chess/zobrist.h"
 
 static void test_fen_roundtrip() {
     const std::string start =
@@ -37,6 +55,675 @@ static void test_make_undo_identity_startpos_one_ply() {
     }
 }
 
+// Bitboards must agree with the mailbox square by square.
+static void check_bitboards_match_board(const chess::Position& p) {
+    chess::Bitboard occ = 0;
+    for (int sq = 0; sq < 64; ++sq) {
+        const chess::Piece pc = p.at(sq);
+        if (pc == chess::EMPTY) continue;
+        occ |= chess::square_bb(sq);
+        assert(chess::test_bit(p.pieces(chess::piece_color(pc), chess::piece_type(pc)), sq));
+    }
+    assert(p.occupied() == occ);
+    assert((p.by_color(chess::WHITE) & p.by_color(chess::BLACK)) == 0);
+}
+
+static void test_bitboards_follow_make_undo() {
+    chess::Position p;
+    // Kiwipete: castling, en passant and promotions all reachable in two plies.
+    assert(chess::from_fen("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", p));
+    check_bitboards_match_board(p);
+    assert(chess::popcount(p.occupied()) == 32);
+
+    std::vector<chess::Move> moves;
+    chess::generate_legal(p, moves);
+    for (const auto& m : moves) {
+        chess::Undo u;
+        chess::make_move(p, m, u);
+        check_bitboards_match_board(p);
+
+        std::vector<chess::Move> replies;
+        chess::generate_legal(p, replies);
+        for (const auto& r : replies) {
+            chess::Undo ur;
+            chess::make_move(p, r, ur);
+            check_bitboards_match_board(p);
+            chess::undo_move(p, r, ur);
+        }
+
+        chess::undo_move(p, m, u);
+        check_bitboards_match_board(p);
+    }
+}
+
+static void check_slider_attacks_match_ray_walk() {
+    std::uint64_t x = 0x1234567890ABCDEFull;
+    for (int i = 0; i < 20000; ++i) {
+        // xorshift; AND two draws so boards are not half full every time
+        x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+        std::uint64_t y = x;
+        x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+        const chess::Bitboard occ = x & y;
+
+        const int sq = i & 63;
+        assert(chess::rook_attacks(sq, occ) == chess::sliding_attacks_slow(sq, occ, true));
+        assert(chess::bishop_attacks(sq, occ) == chess::sliding_attacks_slow(sq, occ, false));
+    }
+}
+
+// Both slider backends must produce identical attack sets (PEXT only if the CPU has BMI2).
+static void test_slider_backends_match_ray_walk() {
+    const auto initial = chess::slider_backend();
+
+    assert(chess::set_slider_backend(chess::SliderBackend::Magic));
+    check_slider_attacks_match_ray_walk();
+
+    if (chess::cpu_has_bmi2()) {
+        assert(chess::set_slider_backend(chess::SliderBackend::Pext));
+        assert(chess::slider_backend() == chess::SliderBackend::Pext);
+        check_slider_attacks_match_ray_walk();
+    } else {
+        assert(!chess::set_slider_backend(chess::SliderBackend::Pext));
+        assert(chess::slider_backend() == chess::SliderBackend::Magic);
+    }
+
+    assert(chess::set_slider_backend(initial));
+}
+
+// Reference legality: make each pseudo-legal move and reject it if our king is attacked.
+static std::vector<std::string> filtered_pseudo_legal_uci(chess::Position& p) {
+    std::vector<chess::Move> pseudo;
+    chess::generate_pseudo_legal(p, pseudo);
+
+    const chess::Color us = p.side_to_move();
+    std::vector<std::string> out;
+    for (const auto& m : pseudo) {
+        chess::Undo u;
+        chess::make_move(p, m, u);
+        if (!chess::is_square_attacked(p, p.king_square(us), chess::opposite(us)))
+            out.push_back(chess::move_to_uci(m));
+        chess::undo_move(p, m, u);
+    }
+    std::sort(out.begin(), out.end());
+    return out;
+}
+
+static std::vector<std::string> legal_uci(const chess::Position& p) {
+    std::vector<chess::Move> moves;
+    chess::generate_legal(p, moves);
+
+    std::vector<std::string> out;
+    for (const auto& m : moves) out.push_back(chess::move_to_uci(m));
+    std::sort(out.begin(), out.end());
+    return out;
+}
+
+static void test_legal_generator_matches_make_undo_filter() {
+    const char* fens[] = {
+        // kiwipete
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        // en passant with horizontal discovered check on the king's rank
+        "8/8/8/KPp4r/8/8/8/7k w - c6 0 2",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+        // double check, checks by pawn/knight, pinned pieces
+        "4k3/8/8/8/1b6/8/3P4/r3K2R w K - 0 1",
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+        "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+        // castling through / out of check
+        "r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1",
+        "4k3/8/8/8/8/8/5r2/R3K2R w KQ - 0 1",
+    };
+
+    for (const char* fen : fens) {
+        chess::Position p;
+        assert(chess::from_fen(fen, p));
+        assert(legal_uci(p) == filtered_pseudo_legal_uci(p));
+
+        std::vector<chess::Move> moves;
+        chess::generate_legal(p, moves);
+        assert(chess::count_legal(p) == static_cast<int>(moves.size()));
+        for (const auto& m : moves) {
+            chess::Undo u;
+            chess::make_move(p, m, u);
+            assert(legal_uci(p) == filtered_pseudo_legal_uci(p));
+            assert(chess::count_legal(p) == static_cast<int>(legal_uci(p).size()));
+            assert(chess::has_legal_move(p) == !legal_uci(p).empty());
+            chess::undo_move(p, m, u);
+        }
+    }
+}
+
+static void test_pawn_on_last_rank_has_no_moves() {
+    // from_fen accepts a pawn on its promotion rank; it must not push off the board.
+    for (const char* fen : { "4k2P/8/8/8/8/8/8/4K3 w - - 0 1", "4K3/8/8/8/8/8/8/4k2p b - - 0 1" }) {
+        chess::Position p;
+        assert(chess::from_fen(fen, p));
+
+        std::vector<chess::Move> moves;
+        chess::generate_legal(p, moves);
+        assert(moves.size() == 5); // king moves only
+        for (const auto& m : moves) assert(m.from == p.king_square(p.side_to_move()));
+        assert(chess::count_legal(p) == 5);
+        assert(chess::perft(p, 2) == 25);
+    }
+}
+
+// count_legal is perft's leaf count, so it must agree with generate_legal on
+// everything from_fen accepts, not only on positions reachable in play.
+static void count_legal_matches_generator(chess::Position& p, int depth) {
+    std::vector<chess::Move> moves;
+    chess::generate_legal(p, moves);
+    assert(chess::count_legal(p) == static_cast<int>(moves.size()));
+    assert(chess::has_legal_move(p) == !moves.empty());
+    if (depth == 0) return;
+
+    for (const auto& m : moves) {
+        chess::Undo u;
+        chess::make_move(p, m, u);
+        count_legal_matches_generator(p, depth - 1);
+        chess::undo_move(p, m, u);
+    }
+}
+
+static void test_count_legal_on_edge_rank_pawns() {
+    const char* fens[] = {
+        // pawns on their own last rank, blocked or not, next to enemy pieces
+        "4k2P/8/8/8/8/8/8/4K3 w - - 0 1",
+        "P2nk2P/8/8/8/8/8/8/4K3 w - - 0 1",
+        "4k3/8/8/8/8/8/8/p3K1Bp b - - 0 1",
+        // pawns on their own first rank, free or blocked
+        "4k3/8/8/8/8/8/8/P2QK2P w - - 0 1",
+        "p3k1np/8/8/8/8/8/8/4K3 b - - 0 1",
+        "p3k2p/7N/8/8/8/8/8/4K3 b - - 0 1",
+        // both at once, with a pin along the back rank and a check
+        "P3k2r/8/8/8/8/8/8/R3K2p w Q - 0 1",
+        "r2Pk2P/8/8/8/8/8/5p2/4K2p w - - 0 1",
+    };
+
+    for (const char* fen : fens) {
+        chess::Position p;
+        assert(chess::from_fen(fen, p));
+        count_legal_matches_generator(p, 2);
+    }
+}
+
+static void test_resolve_move_matches_generator() {
+    const char* fens[] = {
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "8/8/8/KPp4r/8/8/8/7k w - c6 0 2",
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+        "4k3/8/8/8/8/8/5r2/R3K2R w KQ - 0 1",
+        "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3",
+    };
+
+    for (const char* fen : fens) {
+        chess::Position p;
+        assert(chess::from_fen(fen, p));
+
+        std::vector<chess::Move> legal;
+        chess::generate_legal(p, legal);
+
+        // Every from/to/promo triple resolves iff the generator produced it,
+        // and to the generator's flags.
+        for (int from = 0; from < 64; ++from) {
+            for (int to = 0; to < 64; ++to) {
+                for (int promo : { chess::PT_NONE, chess::PT_KNIGHT, chess::PT_BISHOP, chess::PT_ROOK, chess::PT_QUEEN }) {
+                    const chess::Move m(static_cast<uint8_t>(from), static_cast<uint8_t>(to), chess::MF_NONE,
+                                        static_cast<uint8_t>(promo));
+                    auto it = std::find_if(legal.begin(), legal.end(), [&](const chess::Move& lm) {
+                        return lm.from == from && lm.to == to && lm.promo == promo;
+                    });
+
+                    const std::optional<chess::Move> r = chess::resolve_move(p, m);
+                    assert(r.has_value() == (it != legal.end()));
+                    assert(chess::is_legal(p, m) == r.has_value());
+                    if (r) assert(r->flags == it->flags);
+                }
+            }
+        }
+    }
+
+    // Game validates through it: flags come from the position, not the caller.
+    chess::Game g;
+    assert(g.set_fen("rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3"));
+    assert(g.play_uci("e5f6"));
+    assert(chess::is_en_passant(g.moves().back()));
+    assert(!g.play_uci("e8e7q"));
+    assert(!g.play_uci("a1a1"));
+}
+
+static void test_packed_move_roundtrip() {
+    static_assert(sizeof(chess::PackedMove) == 2);
+    constexpr chess::PackedMove e2e4(12, 28, chess::MK_DOUBLE_PUSH);
+    static_assert(e2e4.from() == 12 && e2e4.to() == 28 && !e2e4.is_capture() && !e2e4.is_promotion());
+    static_assert(chess::is_double_push(chess::Move(e2e4)));
+
+    constexpr chess::PackedMove promo(chess::Move(52, 61, chess::MF_CAPTURE | chess::MF_PROMOTION, chess::PT_KNIGHT));
+    static_assert(promo.kind() == chess::MK_PROMO_KNIGHT_CAPTURE && promo.promo() == chess::PT_KNIGHT);
+    assert(chess::move_to_uci(promo) == "e7f8n");
+
+    const auto parsed = chess::parse_uci_move("b2b1q");
+    assert(parsed && chess::PackedMove(*parsed).kind() == chess::MK_PROMO_QUEEN);
+
+    // Every generated move survives Move -> PackedMove -> Move unchanged
+    // (castling, en passant and promotions included).
+    for (const char* fen : { "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+                             "r3k2r/p1ppqpb1/bn2pnp1/3PN3/Pp2P3/2N2Q1p/1PPBBPPP/R3K2R b KQkq a3 0 1",
+                             "n1n5/PPPk4/8/8/8/8/4Kppp/5N1N b - - 0 1" }) {
+        chess::Position p;
+        assert(chess::from_fen(fen, p));
+        std::vector<chess::Move> moves;
+        chess::generate_pseudo_legal(p, moves);
+        for (const chess::Move& m : moves) {
+            const chess::Move back = chess::PackedMove(m);
+            assert(back.from == m.from && back.to == m.to && back.flags == m.flags && back.promo == m.promo);
+        }
+    }
+}
+
+static void test_movelist_matches_vector_overload() {
+    chess::Position p;
+    assert(chess::from_fen("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", p));
+
+    chess::MoveList list;
+    std::vector<chess::Move> vec;
+    chess::generate_legal(p, list);
+    chess::generate_legal(p, vec);
+
+    assert(list.size() == 48 && vec.size() == list.size());
+    for (size_t i = 0; i < vec.size(); ++i) {
+        const chess::Move m = list[i];
+        assert(m.from == vec[i].from && m.to == vec[i].to);
+        assert(m.flags == vec[i].flags && m.promo == vec[i].promo);
+    }
+
+    // Regenerating into the same list replaces, not appends.
+    chess::generate_legal(chess::Position::startpos(), list);
+    assert(list.size() == 20);
+}
+
+// Walks the tree to `depth`, checking the incremental key at every node.
+static void check_incremental_key(chess::Position& p, int depth) {
+    assert(p.key() == chess::zobrist_key(p));
+    if (depth == 0) return;
+
+    chess::MoveList moves;
+    chess::generate_legal(p, moves);
+    for (const auto& m : moves) {
+        const auto before = p.key();
+        chess::Undo u;
+        chess::make_move(p, m, u);
+        check_incremental_key(p, depth - 1);
+        chess::undo_move(p, m, u);
+        assert(p.key() == before);
+    }
+}
+
+static void test_incremental_zobrist_key() {
+    const char* fens[] = {
+        "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+        "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+        "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    };
+    for (const char* fen : fens) {
+        chess::Position p;
+        assert(chess::from_fen(fen, p));
+        check_incremental_key(p, 3);
+    }
+
+    chess::Position start = chess::Position::startpos();
+    assert(start.key() == chess::zobrist_key(start));
+}
+
+static void test_perft_table() {
+    chess::PerftTable table(1);
+    assert(table.enabled() && table.size_mb() == 1);
+
+    std::uint64_t n = 0;
+    assert(!table.probe(0xABCDEFull, 3, n));
+    table.store(0xABCDEFull, 3, 97862);
+    assert(table.probe(0xABCDEFull, 3, n) && n == 97862);
+    assert(!table.probe(0xABCDEFull, 4, n));          // depth is part of the key
+    assert(!table.probe(0xABCDEFull ^ (1ull << 40), 3, n)); // same bucket, different key
+
+    // Cached perft must match plain perft, including on a warm second run.
+    chess::Position p;
+    assert(chess::from_fen("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", p));
+    assert(chess::perft(p, 3, &table) == 97862);
+    assert(chess::perft(p, 3, &table) == 97862);
+    assert(chess::to_fen(p) == "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+
+    table.clear();
+    assert(!table.probe(0xABCDEFull, 3, n));
+
+    table.resize(0);
+    assert(!table.enabled());
+    assert(chess::perft(p, 2, &table) == 2039);
+}
+
+static void test_perft_table_file() {
+    const std::string path = (std::filesystem::temp_directory_path() / "chess_unit_perft.cache").string();
+    std::remove(path.c_str());
+
+    std::string error;
+    std::uint64_t n = 0;
+    {
+        chess::PerftTable table;
+        assert(table.open_file(path, 1, error) && table.persistent() && table.size_mb() == 1);
+        table.store(0xABCDEFull, 3, 97862);
+    }
+    {
+        // Survives the process (here: the object) that wrote it.
+        chess::PerftTable table;
+        assert(table.open_file(path, 8, error) && table.size_mb() == 1);
+        assert(table.probe(0xABCDEFull, 3, n) && n == 97862);
+
+        // Two mappings of one file see each other's stores.
+        chess::PerftTable other;
+        assert(other.open_file(path, 1, error));
+        other.store(0x123456ull, 5, 4865609);
+        assert(table.probe(0x123456ull, 5, n) && n == 4865609);
+    }
+    // A process still mapping the file while it is wiped or replaced keeps
+    // a readable mapping (no SIGBUS from a shrunken file).
+    chess::PerftTable running;
+    assert(running.open_file(path, 1, error));
+    {
+        // Written by another move generator build: wiped, not trusted.
+        std::fstream f(path, std::ios::in | std::ios::out | std::ios::binary);
+        f.seekg(8);
+        const char c = static_cast<char>(f.get());
+        f.seekp(8);
+        f.put(static_cast<char>(c ^ 0x5A)); // flip bits of the build id
+    }
+    {
+        chess::PerftTable table;
+        assert(table.open_file(path, 1, error));
+        assert(!table.probe(0xABCDEFull, 3, n));
+        assert(std::filesystem::file_size(path) == (1u << 20) + 64); // wiped in place
+        assert(!running.probe(0xABCDEFull, 3, n));
+    }
+    {
+        // Malformed (wrong size): replaced by a fresh file.
+        std::ofstream(path, std::ios::app) << "junk";
+        chess::PerftTable table;
+        assert(table.open_file(path, 2, error) && table.size_mb() == 2);
+        assert(!table.probe(0x123456ull, 5, n));
+        running.store(0x123456ull, 5, 1);
+        assert(!table.probe(0x123456ull, 5, n)); // the old mapping no longer shares storage
+    }
+
+    chess::PerftTable table;
+    assert(!table.open_file((std::filesystem::temp_directory_path() / "no/such/dir/x.cache").string(), 1, error));
+    assert(!table.enabled() && !error.empty());
+
+    std::remove(path.c_str());
+}
+
+static void test_parallel_perft_matches_serial() {
+    struct Case { const char* fen; int depth; std::uint64_t nodes; };
+    const Case cases[] = {
+        { "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 3, 97862 },
+        // few root moves: forces splitting below the root
+        { "4k3/8/8/8/8/8/8/4K2R w K - 0 1", 5, 133987 },
+        // Rd8# at the root: a subtree with zero nodes
+        { "6k1/5ppp/8/8/8/8/8/K2R4 w - - 0 1", 4, 14932 },
+    };
+
+    for (const auto& c : cases) {
+        chess::Position p;
+        assert(chess::from_fen(c.fen, p));
+        chess::Position copy = p;
+        const std::uint64_t serial = chess::perft(copy, c.depth);
+        assert(serial == c.nodes);
+
+        for (unsigned threads : { 2u, 4u, 7u }) {
+            assert(chess::perft_parallel(p, c.depth, threads) == serial);
+
+            chess::PerftTable table(1);
+            assert(chess::perft_parallel(p, c.depth, threads, &table) == serial);
+
+            const auto per_move = chess::perft_divide_counts(p, c.depth, threads);
+            const auto serial_per_move = chess::perft_divide_counts(p, c.depth, 1);
+            assert(per_move.size() == serial_per_move.size());
+            for (size_t i = 0; i < per_move.size(); ++i)
+                assert(per_move[i].second == serial_per_move[i].second);
+        }
+    }
+}
+
+static void test_perft_by_depth() {
+    chess::Position p;
+    assert(chess::from_fen("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", p));
+    const auto counts = chess::perft_by_depth(p, 3);
+    assert(counts.size() == 3);
+    assert(counts[0] == 48 && counts[1] == 2039 && counts[2] == 97862);
+
+    // Mate at the root: nothing below depth 1.
+    assert(chess::from_fen("3R2k1/5ppp/8/8/8/8/8/K7 b - - 0 1", p));
+    const auto mated = chess::perft_by_depth(p, 2);
+    assert(mated.size() == 2 && mated[0] == 0 && mated[1] == 0);
+    assert(chess::perft_by_depth(p, 0).empty());
+}
+
+static void test_distributed_perft_resumes_from_checkpoint() {
+    chess::Position p;
+    assert(chess::from_fen("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", p));
+
+    const auto subtrees = chess::split_perft_subtrees(p, 3, 1);
+    assert(subtrees.size() == 48 && subtrees[0].depth == 2);
+
+    const std::string ckpt = (std::filesystem::temp_directory_path() / "chess_unit_perft.ckpt").string();
+    std::remove(ckpt.c_str());
+
+    chess::DistributedPerftOptions opts;
+    opts.workers = 3;
+    opts.split_depth = 2;
+    opts.checkpoint = ckpt;
+
+    auto res = chess::perft_distributed(p, 3, opts);
+    assert(res.ok && res.nodes == 97862 && res.resumed == 0);
+    assert(res.divide.size() == 48);
+
+    // Keep the header and ten records, plus a record cut off mid-write.
+    std::vector<std::string> lines;
+    {
+        std::ifstream in(ckpt);
+        std::string line;
+        while (std::getline(in, line)) lines.push_back(line);
+    }
+    assert(lines.size() == 1 + res.subtrees);
+    {
+        std::ofstream out(ckpt, std::ios::trunc);
+        for (int i = 0; i <= 10; ++i) out << lines[i] << '\n';
+        out << lines[11].substr(0, lines[11].size() - 1);
+    }
+
+    res = chess::perft_distributed(p, 3, opts);
+    assert(res.ok && res.nodes == 97862 && res.resumed == 10);
+
+    // The cut-off record was dropped, so the file is complete again.
+    res = chess::perft_distributed(p, 3, opts);
+    assert(res.ok && res.nodes == 97862 && res.resumed == res.subtrees);
+
+    // A checkpoint from another run is refused, not mixed in.
+    opts.split_depth = 1;
+    res = chess::perft_distributed(p, 3, opts);
+    assert(!res.ok);
+
+    std::remove(ckpt.c_str());
+}
+
+static void test_bench_json_and_regression_check() {
+    auto entry = [](const char* name, const char* fen, int depth, std::uint64_t nodes, double ms) {
+        chess::BenchEntry e;
+        e.name = name;
+        e.fen = fen;
+        e.depth = depth;
+        e.nodes = nodes;
+        e.ms = ms;
+        return e;
+    };
+
+    chess::BenchReport base;
+    base.sliders = "magic";
+    base.reps = 3;
+    base.entries.push_back(entry("startpos", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 5, 4865609, 100.0));
+    base.entries.push_back(entry("kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 4, 4085603, 80.0));
+    base.entries[1].counters.value[chess::PERF_BRANCH_MISSES] = 12345;
+    base.entries[1].counters.has[chess::PERF_BRANCH_MISSES] = true;
+
+    chess::BenchReport read;
+    std::string error;
+    assert(chess::bench_from_json(chess::bench_to_json(base), read, error));
+    assert(read.sliders == "magic" && read.reps == 3 && read.entries.size() == 2);
+    assert(read.entries[1].name == "kiwipete" && read.entries[1].fen == base.entries[1].fen);
+    assert(read.entries[1].depth == 4 && read.entries[1].nodes == 4085603 && read.entries[1].ms == 80.0);
+    assert(read.nodes() == base.nodes());
+    assert(!read.entries[0].counters.any());
+    assert(read.entries[1].counters.has[chess::PERF_BRANCH_MISSES] &&
+           read.entries[1].counters.value[chess::PERF_BRANCH_MISSES] == 12345);
+
+    assert(!chess::bench_from_json("{ \"positions\": [ { \"name\": \"x\" } ] }", read, error));
+    assert(!chess::bench_from_json("[1, 2", read, error));
+
+    std::ostringstream out;
+    chess::BenchReport now = base;
+    now.sliders = "pext";
+    now.entries[0].ms = 104.0; // ~2% slower overall: within 5%
+    assert(!chess::report_bench_regression(out, now, base, 5.0));
+    now.entries[1].ms = 100.0; // ~12% slower overall
+    assert(chess::report_bench_regression(out, now, base, 5.0));
+    assert(!chess::report_bench_regression(out, now, base, 20.0));
+    assert(out.str().find("REGRESSION") != std::string::npos);
+}
+
+static void test_perf_counters_degrade_gracefully() {
+    chess::PerfCounters counters;
+    assert(counters.available() == counters.error().empty());
+
+    counters.start();
+    chess::Position p = chess::Position::startpos();
+    const std::uint64_t nodes = chess::perft(p, 3);
+    const chess::PerfReading r = counters.stop();
+    assert(nodes == 8902);
+    if (!counters.available()) assert(!r.any() && r.per_node(nodes).empty());
+
+    chess::PerfReading fake;
+    fake.value[chess::PERF_CYCLES] = 4000;
+    fake.value[chess::PERF_INSTRUCTIONS] = 10000;
+    fake.has[chess::PERF_CYCLES] = fake.has[chess::PERF_INSTRUCTIONS] = true;
+    assert(fake.any());
+    assert(fake.per_node(100) == "IPC 2.50  cycles/node 40  instructions/node 100");
+}
+
+static void test_alloc_stats_count_heap_traffic() {
+    const chess::AllocScope scope;
+    // Direct calls, which (unlike new-expressions) may not be elided.
+    void* p = ::operator new(100);
+    ::operator delete(p);
+    const chess::AllocCounts c = scope.counts();
+
+    if (!chess::alloc_stats_enabled) {
+        assert(c.allocations == 0 && c.bytes == 0 && c.per_node(10).empty());
+        return;
+    }
+    assert(c.allocations >= 1 && c.bytes >= 100 && c.frees >= 1);
+
+    chess::AllocCounts fixed;
+    fixed.allocations = 5;
+    fixed.bytes = 240;
+    assert(fixed.per_node(10) == "allocs/node 0.500  bytes/node 24.0");
+
+    // An ALLOC_STATS baseline turns any extra allocation into a regression.
+    chess::BenchReport base;
+    chess::BenchEntry e;
+    e.name = "startpos";
+    e.nodes = 1000;
+    e.ms = 1.0;
+    e.has_allocs = true;
+    base.entries.push_back(e);
+
+    chess::BenchReport back;
+    std::string error;
+    assert(chess::bench_from_json(chess::bench_to_json(base), back, error));
+    assert(back.entries[0].has_allocs && back.entries[0].allocs.allocations == 0);
+
+    chess::BenchReport now = base;
+    std::ostringstream out;
+    assert(!chess::report_bench_regression(out, now, base, 50.0));
+    now.entries[0].allocs.allocations = 1;
+    assert(chess::report_bench_regression(out, now, base, 50.0));
+}
+
+static void test_stats_count_hot_paths() {
+    assert(std::string(chess::stat_name(chess::STAT_MAKE_MOVE)) == "make_move");
+    assert(std::string(chess::stat_name(chess::STAT_ILLEGAL_REJECTED)) == "illegal_rejected");
+
+    chess::stats_reset();
+    chess::Position p = chess::Position::startpos();
+    assert(chess::perft(p, 2) == 400);
+    const chess::StatCounts here = chess::stats_snapshot();
+
+    // A thread's counts outlive the thread.
+    std::thread([] {
+        chess::Position q = chess::Position::startpos();
+        assert(chess::perft(q, 2) == 400);
+    }).join();
+    const chess::StatCounts both = chess::stats_snapshot();
+
+    if (!chess::stats_enabled) {
+        assert(here == chess::StatCounts{} && both == chess::StatCounts{});
+        return;
+    }
+    assert(here[chess::STAT_MAKE_MOVE] == 20);
+    assert(here[chess::STAT_UNDO_MOVE] == 20);
+    assert(here[chess::STAT_GENERATE_LEGAL] > 0);
+    assert(here[chess::STAT_COUNT_LEGAL] == 20); // perft leaves are counted, not generated
+    assert(both[chess::STAT_MAKE_MOVE] == 40);
+    assert(both[chess::STAT_GENERATE_LEGAL] == 2 * here[chess::STAT_GENERATE_LEGAL]);
+
+    chess::stats_reset();
+    assert(chess::stats_snapshot() == chess::StatCounts{});
+}
+
+static void test_trace_writes_chrome_json() {
+    const std::string path = (std::filesystem::temp_directory_path() / "chess_unit_trace.json").string();
+    std::string error;
+
+    { chess::TraceScope off("not traced"); }
+    assert(!chess::trace_stop(error));
+
+    assert(chess::trace_start(path, error));
+    chess::trace_thread_name("main");
+    {
+        chess::TraceScope scope("unit case", "a \"quoted\" detail that is longer than thirty-one chars");
+        chess::Position p = chess::Position::startpos();
+        assert(chess::perft_parallel(p, 3, 2) == 8902);
+    }
+    chess::Game g;
+    g.set_player(chess::WHITE, chess::Game::PlayerType::AI);
+    g.set_ai(chess::WHITE, [](const chess::Position&) { return chess::parse_uci_move("e2e4"); });
+    assert(g.step_ai());
+    assert(chess::trace_stop(error));
+
+    std::ifstream in(path);
+    std::stringstream text;
+    text << in.rdbuf();
+    const std::string json = text.str();
+    std::remove(path.c_str());
+
+    assert(json.starts_with("{\"displayTimeUnit\":\"ms\",\"traceEvents\":["));
+    assert(json.find("\"args\":{\"name\":\"main\"}") != std::string::npos);
+    assert(json.find("\"args\":{\"name\":\"pool worker 1\"}") != std::string::npos);
+    assert(json.find("\"args\":{\"detail\":\"a \\\"quoted\\\" detail that is longe\"}") != std::string::npos); // 31 chars
+    assert(json.find("\"name\":\"perft job\"") != std::string::npos);
+    assert(json.find("\"name\":\"ai move\",\"cat\":\"chess\",\"ph\":\"X\"") != std::string::npos);
+    assert(json.find("\"detail\":\"e2e4\"") != std::string::npos);
+    assert(json.find("not traced") == std::string::npos);
+    assert(json.ends_with("\"dropped_events\":0}}\n"));
+}
+
 static void test_threefold_repetition_draw() {
     chess::Game g;
     // Start position is already occurrence #1
@@ -82,11 +769,57 @@ static void test_fifty_move_draw() {
     // you'd expect it to go back to ongoing. Here we just confirm it triggers.
 }
 
+static void test_checkmate_and_stalemate() {
+    struct Case {
+        const char* fen;
+        chess::GameResult expected;
+    };
+    const Case cases[] = {
+        // fool's mate
+        { "rnb1kbnr/pppp1ppp/8/4p3/6Pq/5P2/PPPPP2P/RNBQKBNR w KQkq - 1 3", chess::GameResult::Checkmate },
+        // back-rank mate: the king may not step along the checking ray
+        { "R5k1/5ppp/8/8/8/8/8/6K1 b - - 0 1", chess::GameResult::Checkmate },
+        { "7k/5Q2/6K1/8/8/8/8/8 b - - 0 1", chess::GameResult::Stalemate },
+        // stalemated except for an en passant capture
+        { "7k/5Q2/6K1/8/1Pp5/2P5/8/8 b - b3 0 1", chess::GameResult::Ongoing },
+        { "7k/5Q2/6K1/8/1Pp5/2P5/8/8 b - - 0 1", chess::GameResult::Stalemate },
+    };
+
+    for (const Case& c : cases) {
+        chess::Position p;
+        assert(chess::from_fen(c.fen, p));
+        assert(chess::result(p, 1) == c.expected);
+        assert(chess::is_checkmate(p) == (c.expected == chess::GameResult::Checkmate));
+        assert(chess::is_stalemate(p) == (c.expected == chess::GameResult::Stalemate));
+        assert(chess::has_legal_move(p) == !legal_uci(p).empty());
+    }
+}
+
 int main() {
     test_fen_roundtrip();
     test_make_undo_identity_startpos_one_ply();
+    test_bitboards_follow_make_undo();
+    test_slider_backends_match_ray_walk();
+    test_legal_generator_matches_make_undo_filter();
+    test_pawn_on_last_rank_has_no_moves();
+    test_count_legal_on_edge_rank_pawns();
+    test_resolve_move_matches_generator();
+    test_packed_move_roundtrip();
+    test_movelist_matches_vector_overload();
+    test_incremental_zobrist_key();
+    test_perft_table();
+    test_perft_table_file();
+    test_parallel_perft_matches_serial();
+    test_perft_by_depth();
+    test_distributed_perft_resumes_from_checkpoint();
+    test_bench_json_and_regression_check();
+    test_perf_counters_degrade_gracefully();
+    test_alloc_stats_count_heap_traffic();
+    test_stats_count_hot_paths();
+    test_trace_writes_chrome_json();
     test_threefold_repetition_draw();
     test_fifty_move_draw();
+    test_checkmate_and_stalemate();
     std::cout << "Unit tests passed\n";
     return 0;
 }
\ No newline at end of file
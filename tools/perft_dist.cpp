@@ -0,0 +1,99 @@
+// Deep perft over worker processes, resumable from a checkpoint file.
+//
+//   perft_dist --workers 8 --split 2 --checkpoint kiwi7.ckpt 7 <fen...>
+//
+// Killing the run and starting it again with the same arguments resumes
+// from the subtrees already recorded in the checkpoint.
+
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "chess/fen.h"
+#include "chess/perft_dist.h"
+#include "chess/position.h"
+#include "chess/thread_pool.h"
+
+static void print_usage() {
+    std::cerr << "Usage: perft_dist [--workers N] [--split D] [--checkpoint FILE] [--hash MB] [--progress]\n"
+              << "                  <depth> [fen...]\n"
+              << "  --workers N        worker processes (default: all cores)\n"
+              << "  --split D          plies expanded by the coordinator into subtree jobs (default 2)\n"
+              << "  --checkpoint FILE  record finished subtrees in FILE and resume from it\n"
+              << "  --hash MB          perft table size per worker (default 0: off)\n"
+              << "  --progress         print every finished subtree to stderr\n"
+              << "The FEN defaults to the start position.\n";
+}
+
+int main(int argc, char** argv) {
+    chess::DistributedPerftOptions opts;
+    opts.workers = chess::hardware_threads();
+
+    int depth = -1;
+    std::string fen;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        try {
+            if (arg == "--workers" && i + 1 < argc) {
+                const int n = std::stoi(argv[++i]);
+                if (n < 1) throw std::out_of_range("workers");
+                opts.workers = static_cast<unsigned>(n);
+            } else if (arg == "--split" && i + 1 < argc) {
+                opts.split_depth = std::stoi(argv[++i]);
+                if (opts.split_depth < 0) throw std::out_of_range("split");
+            } else if (arg == "--checkpoint" && i + 1 < argc) {
+                opts.checkpoint = argv[++i];
+            } else if (arg == "--hash" && i + 1 < argc) {
+                const int mb = std::stoi(argv[++i]);
+                if (mb < 0) throw std::out_of_range("hash");
+                opts.hash_mb = static_cast<std::size_t>(mb);
+            } else if (arg == "--progress") {
+                opts.progress = true;
+            } else if (depth < 0 && !arg.starts_with("--")) {
+                depth = std::stoi(arg);
+                if (depth < 0) throw std::out_of_range("depth");
+            } else if (depth >= 0 && !arg.starts_with("--")) {
+                if (!fen.empty()) fen += ' ';
+                fen += arg;
+            } else {
+                print_usage();
+                return 2;
+            }
+        } catch (...) {
+            print_usage();
+            return 2;
+        }
+    }
+
+    if (depth < 0) {
+        print_usage();
+        return 2;
+    }
+
+    chess::Position pos = chess::Position::startpos();
+    if (!fen.empty() && !chess::from_fen(fen, pos)) {
+        std::cerr << "Invalid FEN: " << fen << "\n";
+        return 2;
+    }
+
+    const auto t0 = std::chrono::steady_clock::now();
+    const chess::DistributedPerftResult res = chess::perft_distributed(pos, depth, opts);
+    const auto t1 = std::chrono::steady_clock::now();
+
+    if (!res.ok) {
+        std::cerr << "perft_dist: " << res.error << "\n";
+        if (!opts.checkpoint.empty()) std::cerr << "Finished subtrees are kept in " << opts.checkpoint << "\n";
+        return 1;
+    }
+
+    for (const auto& [move, n] : res.divide) std::cout << move << ": " << n << "\n";
+    std::cout << "Total: " << res.nodes << "\n";
+
+    const double ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+    std::cerr << res.subtrees << " subtrees (" << res.resumed << " from checkpoint), "
+              << opts.workers << " workers, " << ms << " ms\n";
+    return 0;
+}